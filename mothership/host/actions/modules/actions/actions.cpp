@@ -0,0 +1,160 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "modules/actions/actions.h"
+
+static int _count = 0;
+// queued actions by index, in the order they were queued
+static int *_queue = nullptr;
+static int _queued = 0;
+static bool *_stopRequested = nullptr;
+static unsigned long *_lastTick = nullptr;
+
+// a - b of two millisecond stamps on the 32 bit clock
+static uint32_t _elapsed(unsigned long a, unsigned long b)
+{
+	return (uint32_t)a - (uint32_t)b;
+}
+
+static int _find(int i)
+{
+	for (int q = 0; q < _queued; q++)
+	{
+		if (_queue[q] == i)
+		{
+			return q;
+		}
+	}
+	return -1;
+}
+
+static void _dequeue(int i)
+{
+	int q = _find(i);
+	if (q < 0)
+	{
+		return;
+	}
+
+	for (; q < _queued - 1; q++)
+	{
+		_queue[q] = _queue[q + 1];
+	}
+	_queued--;
+}
+
+static void _stop(Action *a, int i, unsigned long now, bool leave)
+{
+	if ((*a).state == MS_RUNNING)
+	{
+		Action *child = (*a).child;
+		if (child != nullptr && (*child).state == MS_CHILD_RUNNING)
+		{
+			(*child).stop(child);
+			(*child).state = MS_NON_ACTIVE;
+		}
+		(*a).stop(a);
+		(*a).lst = now;
+	}
+
+	if (leave || !(*a).frozen)
+	{
+		(*a).state = MS_NON_ACTIVE;
+		_dequeue(i);
+	}
+	else
+	{
+		(*a).state = MS_SCHEDULED;
+	}
+}
+
+void initActionsList(int count)
+{
+	free(_queue);
+	free(_stopRequested);
+	free(_lastTick);
+	_count = count;
+	_queued = 0;
+	_queue = (int *)calloc(count, sizeof(int));
+	_stopRequested = (bool *)calloc(count, sizeof(bool));
+	_lastTick = (unsigned long *)calloc(count, sizeof(unsigned long));
+}
+
+void scheduleAction(ActionsList *list, Action *a)
+{
+	int i = (int)(a - (*list).availableActions);
+	_stopRequested[i] = false;
+	if (_find(i) < 0)
+	{
+		_queue[_queued++] = i;
+		(*a).state = MS_SCHEDULED;
+	}
+}
+
+void requestStop(ActionsList *list, Action *a)
+{
+	_stopRequested[(int)(a - (*list).availableActions)] = true;
+}
+
+void doQueueActions(ActionsList *list, unsigned long now)
+{
+	for (int i = 0; i < _count; i++)
+	{
+		if (_stopRequested[i])
+		{
+			_stopRequested[i] = false;
+			_stop(&(*list).availableActions[i], i, now, true);
+		}
+	}
+
+	// callbacks may queue or stop actions; walk what was queued before
+	int walked = _queued;
+	int *walk = (int *)malloc(sizeof(int) * (walked > 0 ? walked : 1));
+	for (int q = 0; q < walked; q++)
+	{
+		walk[q] = _queue[q];
+	}
+
+	for (int q = 0; q < walked; q++)
+	{
+		int i = walk[q];
+		Action *a = &(*list).availableActions[i];
+
+		if ((*a).state == MS_SCHEDULED && ((*a).lst == 0 || _elapsed(now, (*a).lst) >= (*a).ti))
+		{
+			if ((*a).canStart != nullptr && !(*a).canStart(a))
+			{
+				continue;
+			}
+
+			(*a).state = MS_RUNNING;
+			(*a).st = now;
+			(*a).start(a);
+			_lastTick[i] = now;
+
+			Action *child = (*a).child;
+			if (child != nullptr)
+			{
+				(*child).state = MS_CHILD_RUNNING;
+				(*child).st = now;
+				(*child).start(child);
+			}
+		}
+
+		if ((*a).state == MS_RUNNING)
+		{
+			if ((*a).td > 0 && _elapsed(now, (*a).st) >= (*a).td)
+			{
+				_stop(a, i, now, false);
+				continue;
+			}
+
+			if ((*a).to == 0 || _elapsed(now, _lastTick[i]) >= (*a).to)
+			{
+				(*a).tick(a);
+				_lastTick[i] = now;
+			}
+		}
+	}
+
+	free(walk);
+}
@@ -0,0 +1,58 @@
+#ifndef _ACTIONS_h
+#define _ACTIONS_h
+
+// Test double of the Actions library (main/modules/actions) for the host
+// tests, so they build without the submodule. It keeps the part of the
+// library's contract the scheduler front end relies on:
+//
+// - scheduleAction queues an action; it starts on the first walk where
+//   ti ms have passed since it last stopped (lst, 0 - never) and
+//   canStart agrees, stamping st
+// - a running action ticks every to ms (0 - on every walk) and stops
+//   once td ms have passed since st (0 - never), stamping lst; a frozen
+//   action stays queued for its next run, any other leaves the list
+// - requestStop stops the action on the next walk and takes it out of
+//   the list, frozen or not
+// - a child starts and stops with its parent
+//
+// Millisecond stamps are compared as 32 bit differences, as they are on
+// the ESP32, so the host sees the wrap of the millisecond clock.
+
+#define MS_NON_ACTIVE 0
+#define MS_PENDING 1
+#define MS_SCHEDULED 2
+#define MS_RUNNING 3
+#define MS_CHILD_RUNNING 4
+#define MS_CHILD_PENDING 5
+#define MS_CHILD_SCHEDULED 6
+
+struct Action
+{
+	bool frozen;
+	char *name;
+	unsigned long ti;
+	unsigned long td;
+	unsigned long lst;
+	unsigned long st;
+	unsigned long to;
+	int state;
+	void (*tick)(Action *a);
+	void (*start)(Action *a);
+	void (*stop)(Action *a);
+	bool (*canStart)(Action *a);
+	void *context;
+	Action *child;
+};
+
+struct ActionsList
+{
+	Action *availableActions;
+	int availableActionsCount;
+};
+
+void initActionsList(int count);
+void scheduleAction(ActionsList *list, Action *a);
+void requestStop(ActionsList *list, Action *a);
+void doQueueActions(ActionsList *list, unsigned long now);
+
+#endif
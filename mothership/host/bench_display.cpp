@@ -0,0 +1,125 @@
+// Host benchmark of the partial display flushes.
+//
+//   bench_display [frames]
+//
+// Draws frames that differ from the previous one by a rectangle of
+// the given size (a percentage on the home screen is ~18x8 pixels,
+// a screen change redraws everything) and diffs them against the
+// last flushed frame with ms_display_diff. Reports the cost of the
+// diff and the bytes a flush takes on the bus compared with the full
+// frame the Adafruit library sends, and what that is at 400 kHz
+// (9 bit times per byte).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "modules/ms_display/ms_display.h"
+
+#define BENCH_FRAMES 20000
+#define BENCH_WIDTH 128
+#define BENCH_HEIGHT 64
+#define BENCH_PAGES (BENCH_HEIGHT / 8)
+#define BENCH_MAX_SPANS 32
+
+// the full frame of Adafruit_SSD1306::display: the command list
+// (address, control and 6 bytes) and 1 KB of data in transfers of
+// 31 bytes with an address and a control byte each
+#define BENCH_CHUNK 31
+#define BENCH_FULL_BYTES (8 + BENCH_WIDTH * BENCH_PAGES + 2 * ((BENCH_WIDTH * BENCH_PAGES + BENCH_CHUNK - 1) / BENCH_CHUNK))
+
+#define BENCH_I2C_CLOCK 400000
+
+static uint8_t _frame[BENCH_WIDTH * BENCH_PAGES];
+static uint8_t _flushed[BENCH_WIDTH * BENCH_PAGES];
+static int _frames = BENCH_FRAMES;
+static volatile int _sink = 0;
+
+static uint32_t _seed = 1;
+
+static uint32_t _random()
+{
+	_seed = _seed * 1103515245 + 12345;
+	return (_seed >> 16) & 0x7fff;
+}
+
+static void _setPixel(int x, int y, bool on)
+{
+	if (on)
+	{
+		_frame[x + (y / 8) * BENCH_WIDTH] |= (1 << (y & 7));
+	}
+	else
+	{
+		_frame[x + (y / 8) * BENCH_WIDTH] &= ~(1 << (y & 7));
+	}
+}
+
+// redraws a w x h rectangle at a random position with random pixels
+static void _change(int w, int h)
+{
+	int x0 = (int)(_random() % (BENCH_WIDTH - w + 1));
+	int y0 = (int)(_random() % (BENCH_HEIGHT - h + 1));
+	for (int y = y0; y < y0 + h; y++)
+	{
+		for (int x = x0; x < x0 + w; x++)
+		{
+			_setPixel(x, y, _random() & 1);
+		}
+	}
+}
+
+static double _elapsed(std::chrono::steady_clock::time_point startedAt)
+{
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startedAt).count();
+}
+
+static void _bench(const char *name, int w, int h)
+{
+	MSDisplaySpan spans[BENCH_MAX_SPANS];
+	long bytes = 0;
+	double diffTime = 0;
+
+	memcpy(_flushed, _frame, sizeof(_frame));
+	for (int f = 0; f < _frames; f++)
+	{
+		_change(w, h);
+
+		auto startedAt = std::chrono::steady_clock::now();
+		int count = ms_display_diff(_frame, _flushed, BENCH_WIDTH, BENCH_PAGES, spans, BENCH_MAX_SPANS);
+		diffTime += _elapsed(startedAt);
+
+		// _flushFront sends the full frame when the spans cost as much
+		int spanBytes = count == -1 ? BENCH_FULL_BYTES : ms_display_span_bytes(spans, count);
+		bytes += spanBytes >= BENCH_WIDTH * BENCH_PAGES ? BENCH_FULL_BYTES : spanBytes;
+		_sink += count;
+
+		if (memcmp(_frame, _flushed, sizeof(_frame)) != 0)
+		{
+			fprintf(stderr, "%s: flushed frame differs after frame %d\n", name, f);
+			exit(1);
+		}
+	}
+
+	double perFrame = (double)bytes / _frames;
+	printf("%-24s %10.2f %12.1f %12.1f %10.2f\n", name, diffTime / _frames / 1000.0, perFrame,
+		   perFrame * 9 * 1000000.0 / BENCH_I2C_CLOCK, (double)BENCH_FULL_BYTES / perFrame);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && atoi(argv[1]) > 0)
+	{
+		_frames = atoi(argv[1]);
+	}
+
+	printf("frames: %d, full frame: %d bytes (%.0f us)\n", _frames, BENCH_FULL_BYTES,
+		   BENCH_FULL_BYTES * 9 * 1000000.0 / BENCH_I2C_CLOCK);
+	printf("%-24s %10s %12s %12s %10s\n", "change", "diff us", "bytes/flush", "bus us", "saving");
+	_bench("percentage 18x8", 18, 8);
+	_bench("home line 128x8", 128, 8);
+	_bench("toggle circle 34x34", 34, 34);
+	_bench("screen change 128x64", 128, 64);
+
+	return 0;
+}
@@ -0,0 +1,220 @@
+// Host benchmark of the ADC sample reduction kernels.
+//
+//   bench_filter [samples]
+//
+// Feeds a slowly drifting signal with noise and relay switching spikes
+// (bursts of full scale samples) through each kernel and reports the
+// cost per sample and the error against the clean signal. Blocking
+// kernels reduce 9 consecutive samples; streaming kernels are pushed
+// every sample and read every 64 samples.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "modules/ms_filter/ms_filter.h"
+
+#define BENCH_SAMPLES 2000000
+#define BENCH_READ_EVERY 64
+
+// one spike burst of BENCH_SPIKE_LENGTH samples every BENCH_SPIKE_EVERY
+#define BENCH_SPIKE_EVERY 500
+#define BENCH_SPIKE_LENGTH 3
+#define BENCH_NOISE 40
+
+struct BenchResult
+{
+	double nsPerSample;
+	double meanError;
+	int maxError;
+};
+
+static uint16_t *_signal = nullptr;
+static uint16_t *_clean = nullptr;
+static int _samples = BENCH_SAMPLES;
+static volatile int _sink = 0;
+
+static uint32_t _seed = 1;
+
+static uint32_t _random()
+{
+	_seed = _seed * 1103515245 + 12345;
+	return (_seed >> 16) & 0x7fff;
+}
+
+static void _generate()
+{
+	_signal = (uint16_t *)malloc(_samples * sizeof(uint16_t));
+	_clean = (uint16_t *)malloc(_samples * sizeof(uint16_t));
+
+	for (int i = 0; i < _samples; i++)
+	{
+		// a dry -> wet drift over the whole run
+		int clean = 3000 - (int)((int64_t)1500 * i / _samples);
+		int value = clean + (int)(_random() % (2 * BENCH_NOISE + 1)) - BENCH_NOISE;
+		if (i % BENCH_SPIKE_EVERY < BENCH_SPIKE_LENGTH)
+		{
+			value = 4095;
+		}
+
+		_clean[i] = (uint16_t)clean;
+		_signal[i] = (uint16_t)value;
+	}
+}
+
+static void _error(BenchResult *r, int at, int value, double *sum, int *count)
+{
+	int e = abs(value - (int)_clean[at]);
+	(*sum) += e;
+	(*count)++;
+	if (e > (*r).maxError)
+	{
+		(*r).maxError = e;
+	}
+}
+
+static double _elapsed(std::chrono::steady_clock::time_point startedAt)
+{
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startedAt).count();
+}
+
+static int _compare(const void *a, const void *b)
+{
+	return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+// the old extractMedianPinValueForProperty reduction
+static BenchResult _benchMean9()
+{
+	BenchResult r = {};
+	double sum = 0;
+	int count = 0;
+
+	auto startedAt = std::chrono::steady_clock::now();
+	for (int i = 0; i + 9 <= _samples; i += 9)
+	{
+		int total = 0;
+		for (int j = 0; j < 9; j++)
+		{
+			total += _signal[i + j];
+		}
+		_sink += total / 9;
+	}
+	r.nsPerSample = _elapsed(startedAt) / _samples;
+
+	for (int i = 0; i + 9 <= _samples; i += 9)
+	{
+		int total = 0;
+		for (int j = 0; j < 9; j++)
+		{
+			total += _signal[i + j];
+		}
+		_error(&r, i + 4, total / 9, &sum, &count);
+	}
+	r.meanError = sum / count;
+	return r;
+}
+
+static BenchResult _benchMedian9(bool network)
+{
+	BenchResult r = {};
+	double sum = 0;
+	int count = 0;
+	uint16_t v[9];
+
+	auto startedAt = std::chrono::steady_clock::now();
+	for (int i = 0; i + 9 <= _samples; i += 9)
+	{
+		memcpy(v, &_signal[i], sizeof(v));
+		if (network)
+		{
+			_sink += ms_filter_median9(v);
+		}
+		else
+		{
+			qsort(v, 9, sizeof(uint16_t), &_compare);
+			_sink += v[4];
+		}
+	}
+	r.nsPerSample = _elapsed(startedAt) / _samples;
+
+	for (int i = 0; i + 9 <= _samples; i += 9)
+	{
+		memcpy(v, &_signal[i], sizeof(v));
+		int median = ms_filter_median9(v);
+
+		memcpy(v, &_signal[i], sizeof(v));
+		qsort(v, 9, sizeof(uint16_t), &_compare);
+		if (median != v[4])
+		{
+			fprintf(stderr, "median9 mismatch at %d: %d != %d\n", i, median, v[4]);
+			exit(1);
+		}
+
+		_error(&r, i + 4, median, &sum, &count);
+	}
+	r.meanError = sum / count;
+	return r;
+}
+
+static BenchResult _benchStreaming(int mode, int size, int trim)
+{
+	BenchResult r = {};
+	double sum = 0;
+	int count = 0;
+	MSFilter f;
+	int value;
+
+	ms_filter_init(&f, mode, size, trim);
+	auto startedAt = std::chrono::steady_clock::now();
+	for (int i = 0; i < _samples; i++)
+	{
+		ms_filter_push(&f, _signal[i]);
+		if (i % BENCH_READ_EVERY == 0 && ms_filter_value(&f, &value))
+		{
+			_sink += value;
+		}
+	}
+	r.nsPerSample = _elapsed(startedAt) / _samples;
+
+	ms_filter_init(&f, mode, size, trim);
+	for (int i = 0; i < _samples; i++)
+	{
+		ms_filter_push(&f, _signal[i]);
+		if (i >= size && i % BENCH_READ_EVERY == 0 && ms_filter_value(&f, &value))
+		{
+			// compare with the middle of the window
+			_error(&r, i - size / 2, value, &sum, &count);
+		}
+	}
+	r.meanError = sum / count;
+	return r;
+}
+
+static void _print(const char *name, BenchResult r)
+{
+	printf("%-28s %10.2f %12.2f %10d\n", name, r.nsPerSample, r.meanError, r.maxError);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && atoi(argv[1]) > 0)
+	{
+		_samples = atoi(argv[1]);
+	}
+
+	_generate();
+
+	printf("samples: %d, spike: %d samples every %d\n", _samples, BENCH_SPIKE_LENGTH, BENCH_SPIKE_EVERY);
+	printf("%-28s %10s %12s %10s\n", "kernel", "ns/sample", "mean error", "max error");
+	_print("mean of 9", _benchMean9());
+	_print("median of 9 (qsort)", _benchMedian9(false));
+	_print("median of 9 (network)", _benchMedian9(true));
+	_print("streaming median 15", _benchStreaming(MS_FILTER_MEDIAN, 15, 0));
+	_print("streaming median 31", _benchStreaming(MS_FILTER_MEDIAN, 31, 0));
+	_print("streaming median 64", _benchStreaming(MS_FILTER_MEDIAN, 64, 0));
+	_print("trimmed mean 32/8", _benchStreaming(MS_FILTER_TRIMMED_MEAN, 32, 8));
+	_print("trimmed mean 64/16", _benchStreaming(MS_FILTER_TRIMMED_MEAN, 64, 16));
+
+	return 0;
+}
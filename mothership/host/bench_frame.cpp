@@ -0,0 +1,294 @@
+// Host benchmark of one UI frame, before and after the screens moved
+// from a GFXcanvas16 to the display's own 1-bpp buffer.
+//
+//   bench_frame [frames]
+//
+// Both paths draw the same prompt screen (a stack of four lines at
+// text size 2, as printAlignedTextStack lays it out) with the same
+// glyph code: every lit bit of a 5x5 glyph is a size x size fillRect,
+// as Adafruit_GFX::drawChar does for a GFXfont such as Org_01.
+//
+// canvas16 - new GFXcanvas16 for the screen and one for the text
+//            stack box (malloc + clear); the text is drawn into the
+//            box at 16 bpp, the box is copied into the screen canvas
+//            and the screen canvas into the display buffer pixel by
+//            pixel (drawRGBBitmap -> writePixel -> drawPixel)
+// 1bpp     - clearDisplay, a black fillRect over the box and the text
+//            drawn straight into the display buffer
+//
+// Both paths must leave the same bytes in the display buffer; the
+// bench checks that before timing them. The I2C transfer of the buffer
+// is the same for both and is not part of it; it is measured on the
+// device (timing.ui in the status JSON).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+
+#define BENCH_FRAMES 20000
+#define BENCH_WIDTH 128
+#define BENCH_HEIGHT 64
+
+// Org_01: 5x5 glyphs, 6 pixels apart
+#define BENCH_GLYPH_SIZE 5
+#define BENCH_GLYPH_ADVANCE 6
+// DEFAULT_TEXT_SIZE, FONT_BASELINE_CORRECTION_LARGE and the default
+// spacing of printAlignedTextStack
+#define BENCH_TEXT_SIZE 2
+#define BENCH_BASELINE_CORRECTION 12
+#define BENCH_SPACING 3
+#define BENCH_LINES 4
+
+#define BENCH_BLACK 0
+#define BENCH_WHITE 1
+
+// a drawing target as the screens see it (Adafruit_GFX)
+struct BenchTarget
+{
+	void (*fillRect)(BenchTarget *t, int x, int y, int w, int h, uint16_t color);
+	uint16_t *buffer;
+	int width;
+	int height;
+};
+
+static uint8_t _display[BENCH_WIDTH * BENCH_HEIGHT / 8];
+static int _frames = BENCH_FRAMES;
+static volatile int _sink = 0;
+
+static const char *_prompt[BENCH_LINES] = {"Zone 2", "is dry", "Irrigate", "now?"};
+static uint8_t _glyphs[128][BENCH_GLYPH_SIZE];
+
+static int _boxX, _boxY, _boxWidth, _boxHeight;
+
+// Adafruit_SSD1306::drawPixel (no rotation)
+static void _drawPixel(int x, int y, uint16_t color)
+{
+	if (x < 0 || x >= BENCH_WIDTH || y < 0 || y >= BENCH_HEIGHT)
+	{
+		return;
+	}
+
+	switch (color)
+	{
+	case 1:
+		_display[x + (y / 8) * BENCH_WIDTH] |= (1 << (y & 7));
+		break;
+	case 0:
+		_display[x + (y / 8) * BENCH_WIDTH] &= ~(1 << (y & 7));
+		break;
+	case 2:
+		_display[x + (y / 8) * BENCH_WIDTH] ^= (1 << (y & 7));
+		break;
+	}
+}
+
+// Adafruit_SSD1306::fillRect: a drawFastVLine per column, written a
+// page (8 rows) at a time
+static void _displayFillRect(BenchTarget *t, int x, int y, int w, int h, uint16_t color)
+{
+	for (int cx = x; cx < x + w; cx++)
+	{
+		if (cx < 0 || cx >= BENCH_WIDTH)
+		{
+			continue;
+		}
+
+		int top = y < 0 ? 0 : y;
+		int bottom = y + h > BENCH_HEIGHT ? BENCH_HEIGHT : y + h;
+		for (int cy = top; cy < bottom;)
+		{
+			int rows = 8 - (cy & 7);
+			if (rows > bottom - cy)
+			{
+				rows = bottom - cy;
+			}
+
+			uint8_t mask = (uint8_t)(((1 << rows) - 1) << (cy & 7));
+			uint8_t *b = &_display[cx + (cy / 8) * BENCH_WIDTH];
+			if (color == BENCH_WHITE)
+			{
+				*b |= mask;
+			}
+			else
+			{
+				*b &= ~mask;
+			}
+			cy += rows;
+		}
+	}
+}
+
+// GFXcanvas16::fillRect: a row of 16 bit pixels at a time
+static void _canvasFillRect(BenchTarget *t, int x, int y, int w, int h, uint16_t color)
+{
+	for (int cy = y; cy < y + h; cy++)
+	{
+		if (cy < 0 || cy >= (*t).height)
+		{
+			continue;
+		}
+
+		for (int cx = x; cx < x + w; cx++)
+		{
+			if (cx >= 0 && cx < (*t).width)
+			{
+				(*t).buffer[cx + cy * (*t).width] = color;
+			}
+		}
+	}
+}
+
+// GFXcanvas16::drawPixel
+static void _canvasDrawPixel(BenchTarget *t, int x, int y, uint16_t color)
+{
+	if (x < 0 || x >= (*t).width || y < 0 || y >= (*t).height)
+	{
+		return;
+	}
+	(*t).buffer[x + y * (*t).width] = color;
+}
+
+static int _textWidth(const char *text)
+{
+	return (int)strlen(text) * BENCH_GLYPH_ADVANCE * BENCH_TEXT_SIZE;
+}
+
+// Adafruit_GFX::print of a GFXfont at BENCH_TEXT_SIZE; y is the top of
+// the glyph
+static void _drawText(BenchTarget *t, const char *text, int x, int y)
+{
+	for (const char *c = text; *c != '\0'; c++)
+	{
+		const uint8_t *glyph = _glyphs[(uint8_t)(*c) & 127];
+		for (int gy = 0; gy < BENCH_GLYPH_SIZE; gy++)
+		{
+			for (int gx = 0; gx < BENCH_GLYPH_SIZE; gx++)
+			{
+				if ((glyph[gy] & (1 << gx)) != 0)
+				{
+					(*t).fillRect(t, x + gx * BENCH_TEXT_SIZE, y + gy * BENCH_TEXT_SIZE, BENCH_TEXT_SIZE, BENCH_TEXT_SIZE, BENCH_WHITE);
+				}
+			}
+		}
+		x += BENCH_GLYPH_ADVANCE * BENCH_TEXT_SIZE;
+	}
+}
+
+// the lines of the stack, left aligned in the box at boxX, boxY
+static void _drawStack(BenchTarget *t, int boxX, int boxY)
+{
+	int y = boxY + BENCH_BASELINE_CORRECTION - BENCH_GLYPH_SIZE * BENCH_TEXT_SIZE;
+	for (int i = 0; i < BENCH_LINES; i++)
+	{
+		_drawText(t, _prompt[i], boxX, y);
+		y += BENCH_GLYPH_SIZE * BENCH_TEXT_SIZE + BENCH_SPACING;
+	}
+}
+
+static void _frameCanvas16()
+{
+	BenchTarget screen = {&_canvasFillRect, nullptr, BENCH_WIDTH, BENCH_HEIGHT};
+	screen.buffer = (uint16_t *)malloc(BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint16_t));
+	memset(screen.buffer, 0, BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint16_t));
+
+	BenchTarget box = {&_canvasFillRect, nullptr, _boxWidth, _boxHeight};
+	box.buffer = (uint16_t *)malloc(_boxWidth * _boxHeight * sizeof(uint16_t));
+	memset(box.buffer, 0, _boxWidth * _boxHeight * sizeof(uint16_t));
+
+	_drawStack(&box, 0, 0);
+
+	// drawRGBBitmap of the box on the screen canvas
+	for (int y = 0; y < _boxHeight; y++)
+	{
+		for (int x = 0; x < _boxWidth; x++)
+		{
+			_canvasDrawPixel(&screen, _boxX + x, _boxY + y, box.buffer[x + y * _boxWidth]);
+		}
+	}
+
+	// drawRGBBitmap of the screen canvas on the display
+	for (int y = 0; y < BENCH_HEIGHT; y++)
+	{
+		for (int x = 0; x < BENCH_WIDTH; x++)
+		{
+			_drawPixel(x, y, screen.buffer[x + y * BENCH_WIDTH]);
+		}
+	}
+
+	free(box.buffer);
+	free(screen.buffer);
+}
+
+static void _frame1bpp()
+{
+	BenchTarget display = {&_displayFillRect, nullptr, BENCH_WIDTH, BENCH_HEIGHT};
+	memset(_display, 0, sizeof(_display));
+	_displayFillRect(&display, _boxX, _boxY, _boxWidth, _boxHeight, BENCH_BLACK);
+	_drawStack(&display, _boxX, _boxY);
+}
+
+static double _bench(void (*frame)())
+{
+	auto startedAt = std::chrono::steady_clock::now();
+	for (int f = 0; f < _frames; f++)
+	{
+		frame();
+		_sink += _display[f % sizeof(_display)];
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startedAt).count() / _frames;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && atoi(argv[1]) > 0)
+	{
+		_frames = atoi(argv[1]);
+	}
+
+	// glyphs with ~half of their bits lit, as the letters of Org_01
+	uint32_t seed = 1;
+	for (int c = 0; c < 128; c++)
+	{
+		for (int r = 0; r < BENCH_GLYPH_SIZE; r++)
+		{
+			seed = seed * 1103515245 + 12345;
+			_glyphs[c][r] = (uint8_t)((seed >> 16) & 0x1f);
+		}
+	}
+
+	// the box of printAlignedTextStack, centred on the screen
+	_boxWidth = 0;
+	for (int i = 0; i < BENCH_LINES; i++)
+	{
+		if (_textWidth(_prompt[i]) > _boxWidth)
+		{
+			_boxWidth = _textWidth(_prompt[i]);
+		}
+	}
+	_boxHeight = BENCH_LINES * BENCH_GLYPH_SIZE * BENCH_TEXT_SIZE + (BENCH_LINES - 1) * BENCH_SPACING + BENCH_BASELINE_CORRECTION;
+	_boxX = BENCH_WIDTH / 2 - _boxWidth / 2;
+	_boxY = BENCH_HEIGHT / 2 - _boxHeight / 2;
+
+	uint8_t before[sizeof(_display)];
+	_frameCanvas16();
+	memcpy(before, _display, sizeof(_display));
+	_frame1bpp();
+	if (memcmp(before, _display, sizeof(_display)) != 0)
+	{
+		printf("canvas16 and 1bpp frames differ\n");
+		return 1;
+	}
+
+	printf("frames: %d, box: %dx%d\n", _frames, _boxWidth, _boxHeight);
+	printf("%-28s %12s %14s\n", "path", "us/frame", "heap/frame");
+	double canvas16 = _bench(&_frameCanvas16);
+	double bpp = _bench(&_frame1bpp);
+	printf("%-28s %12.2f %14d\n", "canvas16 + drawRGBBitmap", canvas16 / 1000.0,
+		   (int)((BENCH_WIDTH * BENCH_HEIGHT + _boxWidth * _boxHeight) * sizeof(uint16_t)));
+	printf("%-28s %12.2f %14d\n", "1-bpp display buffer", bpp / 1000.0, 0);
+	printf("speedup: %.1fx\n", canvas16 / bpp);
+
+	return 0;
+}
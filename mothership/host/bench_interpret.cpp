@@ -0,0 +1,153 @@
+// Host benchmark of the raw reading -> percentage conversion.
+//
+//   bench_interpret [rounds]
+//
+// Converts the readings of BENCH_ZONES zones with random calibrations
+// through the float path tickInterpret used (a division per sensor)
+// and through the ms_interpret fixed point kernel, and reports the
+// cost per reading. Every reading of a set of calibrations is then
+// checked against the exact integer result 100 * (dry - v) / (dry - wet)
+// and the mismatches of both paths are counted.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "modules/ms_interpret/ms_interpret.h"
+
+#define BENCH_ROUNDS 200000
+#define BENCH_ZONES 16
+
+// calibrations checked exhaustively: every BENCH_CHECK_STEP-th wet value
+// with every BENCH_CHECK_STEP-th dry value above it
+#define BENCH_CHECK_STEP 17
+#define BENCH_ADC_MAX 4095
+
+static int _value[BENCH_ZONES];
+static int _dry[BENCH_ZONES];
+static int _wet[BENCH_ZONES];
+static uint32_t _scale[BENCH_ZONES];
+static int _p[BENCH_ZONES];
+static int _rounds = BENCH_ROUNDS;
+static volatile int _sink = 0;
+
+static uint32_t _seed = 1;
+
+static uint32_t _random()
+{
+	_seed = _seed * 1103515245 + 12345;
+	return (_seed >> 16) & 0x7fff;
+}
+
+// the conversion of the float tickInterpret
+static int _floatPercent(int value, int dry, int wet)
+{
+	float v = (float)value;
+	float d = (float)dry;
+	float w = (float)wet;
+	float dwd = d - w > 0.00001f ? d - w : 0.00001f;
+	float c = v < w ? w : v;
+	c = c > d ? d : c;
+	return (int)(((d - c) / dwd) * 100.0f);
+}
+
+static int _exactPercent(int value, int dry, int wet)
+{
+	if (dry <= wet)
+	{
+		return 0;
+	}
+	int c = value < wet ? wet : (value > dry ? dry : value);
+	return 100 * (dry - c) / (dry - wet);
+}
+
+static double _elapsed(std::chrono::steady_clock::time_point startedAt)
+{
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startedAt).count();
+}
+
+static double _benchFloat()
+{
+	auto startedAt = std::chrono::steady_clock::now();
+	for (int r = 0; r < _rounds; r++)
+	{
+		for (int i = 0; i < BENCH_ZONES; i++)
+		{
+			_value[i] += r & 1 ? 1 : -1;
+		}
+		for (int i = 0; i < BENCH_ZONES; i++)
+		{
+			_p[i] = _floatPercent(_value[i], _dry[i], _wet[i]);
+		}
+		_sink += _p[r % BENCH_ZONES];
+	}
+	return _elapsed(startedAt) / ((double)_rounds * BENCH_ZONES);
+}
+
+static double _benchFixed()
+{
+	auto startedAt = std::chrono::steady_clock::now();
+	for (int r = 0; r < _rounds; r++)
+	{
+		for (int i = 0; i < BENCH_ZONES; i++)
+		{
+			_value[i] += r & 1 ? 1 : -1;
+		}
+		ms_interpret_percents(_value, _dry, _wet, _scale, _p, BENCH_ZONES);
+		_sink += _p[r % BENCH_ZONES];
+	}
+	return _elapsed(startedAt) / ((double)_rounds * BENCH_ZONES);
+}
+
+static void _check()
+{
+	long readings = 0;
+	long floatMismatches = 0;
+	long fixedMismatches = 0;
+
+	for (int wet = 0; wet < BENCH_ADC_MAX; wet += BENCH_CHECK_STEP)
+	{
+		for (int dry = wet; dry <= BENCH_ADC_MAX; dry += BENCH_CHECK_STEP)
+		{
+			uint32_t scale = ms_interpret_scale(dry, wet);
+			for (int v = 0; v <= BENCH_ADC_MAX; v++)
+			{
+				int exact = _exactPercent(v, dry, wet);
+				readings++;
+				if (_floatPercent(v, dry, wet) != exact)
+				{
+					floatMismatches++;
+				}
+				if (ms_interpret_percent(v, dry, wet, scale) != exact)
+				{
+					fixedMismatches++;
+				}
+			}
+		}
+	}
+
+	printf("checked readings: %ld, float mismatches: %ld, fixed mismatches: %ld\n", readings, floatMismatches, fixedMismatches);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && atoi(argv[1]) > 0)
+	{
+		_rounds = atoi(argv[1]);
+	}
+
+	for (int i = 0; i < BENCH_ZONES; i++)
+	{
+		_wet[i] = 800 + (int)(_random() % 600);
+		_dry[i] = 2400 + (int)(_random() % 1200);
+		_value[i] = _wet[i] + (int)(_random() % (_dry[i] - _wet[i]));
+	}
+	ms_interpret_scales(_dry, _wet, _scale, BENCH_ZONES);
+
+	printf("zones: %d, rounds: %d\n", BENCH_ZONES, _rounds);
+	printf("%-28s %10s\n", "kernel", "ns/reading");
+	printf("%-28s %10.2f\n", "float division", _benchFloat());
+	printf("%-28s %10.2f\n", "fixed point (Q24)", _benchFixed());
+
+	_check();
+	return 0;
+}
@@ -0,0 +1,205 @@
+// Host benchmark of the text bounds cache.
+//
+//   bench_layout [frames]
+//
+// Measures the texts of a typical screen every frame (a caption,
+// three menu entries, the back prompt and a value that changes every
+// few frames) with a model of Adafruit_GFX::getTextBounds for a GFX
+// font, and through the ms_layout cache in front of it. Each text is
+// measured twice per frame, as printAlignedTextStack does. Random
+// texts are then checked against the model so a hit never returns
+// stale bounds.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+#include "modules/ms_layout/ms_layout.h"
+
+#define BENCH_FRAMES 200000
+#define BENCH_CHECKS 200000
+
+#define BENCH_FIRST_CHAR 0x20
+#define BENCH_LAST_CHAR 0x7e
+
+// GFXglyph
+struct BenchGlyph
+{
+	uint16_t bitmapOffset;
+	uint8_t width;
+	uint8_t height;
+	uint8_t xAdvance;
+	int8_t xOffset;
+	int8_t yOffset;
+};
+
+static BenchGlyph _glyphs[BENCH_LAST_CHAR - BENCH_FIRST_CHAR + 1];
+static MSLayoutCache _cache;
+static int _frames = BENCH_FRAMES;
+static volatile int _sink = 0;
+
+static uint32_t _seed = 1;
+
+static uint32_t _random()
+{
+	_seed = _seed * 1103515245 + 12345;
+	return (_seed >> 16) & 0x7fff;
+}
+
+// Adafruit_GFX::charBounds for a GFX font, without wrapping
+static void _charBounds(unsigned char c, int16_t *x, int16_t *y, int16_t *minx, int16_t *miny, int16_t *maxx, int16_t *maxy, int size)
+{
+	if (c == '\n')
+	{
+		(*x) = 0;
+		(*y) += size * 6;
+		return;
+	}
+	if (c == '\r' || c < BENCH_FIRST_CHAR || c > BENCH_LAST_CHAR)
+	{
+		return;
+	}
+
+	BenchGlyph *glyph = &_glyphs[c - BENCH_FIRST_CHAR];
+	int16_t x1 = (*x) + glyph->xOffset * size;
+	int16_t y1 = (*y) + glyph->yOffset * size;
+	int16_t x2 = x1 + glyph->width * size - 1;
+	int16_t y2 = y1 + glyph->height * size - 1;
+	if (x1 < (*minx))
+	{
+		(*minx) = x1;
+	}
+	if (y1 < (*miny))
+	{
+		(*miny) = y1;
+	}
+	if (x2 > (*maxx))
+	{
+		(*maxx) = x2;
+	}
+	if (y2 > (*maxy))
+	{
+		(*maxy) = y2;
+	}
+	(*x) += glyph->xAdvance * size;
+}
+
+// Adafruit_GFX::getTextBounds
+static void _getTextBounds(const char *text, int size, uint16_t *w, uint16_t *h)
+{
+	int16_t x = 0, y = 0;
+	int16_t minx = 0x7fff, miny = 0x7fff, maxx = -1, maxy = -1;
+	unsigned char c;
+	while ((c = *text++))
+	{
+		_charBounds(c, &x, &y, &minx, &miny, &maxx, &maxy, size);
+	}
+
+	(*w) = maxx >= minx ? maxx - minx + 1 : 0;
+	(*h) = maxy >= miny ? maxy - miny + 1 : 0;
+}
+
+static void _cachedBounds(const char *text, int size, uint16_t *w, uint16_t *h)
+{
+	if (ms_layout_find(&_cache, text, size, w, h))
+	{
+		return;
+	}
+	_getTextBounds(text, size, w, h);
+	ms_layout_store(&_cache, text, size, *w, *h);
+}
+
+static double _elapsed(std::chrono::steady_clock::time_point startedAt)
+{
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startedAt).count();
+}
+
+static double _bench(bool cached)
+{
+	char value[20];
+	const char *texts[] = {"Settings", "1. Sensors", "2. Pump", "3. Thresholds", "B1 - Back", value};
+	const int count = sizeof(texts) / sizeof(texts[0]);
+
+	auto startedAt = std::chrono::steady_clock::now();
+	for (int f = 0; f < _frames; f++)
+	{
+		sprintf(value, "Value: %d+-%d", 1800 + f / 8 % 200, 3);
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				uint16_t w, h;
+				if (cached)
+				{
+					_cachedBounds(texts[i], 1 + i % 2, &w, &h);
+				}
+				else
+				{
+					_getTextBounds(texts[i], 1 + i % 2, &w, &h);
+				}
+				_sink += w + h;
+			}
+		}
+	}
+	return _elapsed(startedAt) / _frames;
+}
+
+static void _check()
+{
+	char text[MS_LAYOUT_MAX_TEXT + 8];
+	long mismatches = 0;
+
+	ms_layout_reset(&_cache);
+	for (int i = 0; i < BENCH_CHECKS; i++)
+	{
+		// short texts from a small alphabet collide in the slots often
+		int length = (int)(_random() % (MS_LAYOUT_MAX_TEXT + 4));
+		for (int j = 0; j < length; j++)
+		{
+			text[j] = "ab1 %"[_random() % 5];
+		}
+		text[length] = '\0';
+		int size = 1 + (int)(_random() % 2);
+
+		uint16_t w, h, ew, eh;
+		_cachedBounds(text, size, &w, &h);
+		_getTextBounds(text, size, &ew, &eh);
+		if (w != ew || h != eh)
+		{
+			mismatches++;
+		}
+	}
+
+	printf("checked texts: %d, mismatches: %ld, hits: %lu, misses: %lu\n", BENCH_CHECKS, mismatches,
+		   (unsigned long)_cache.hits, (unsigned long)_cache.misses);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && atoi(argv[1]) > 0)
+	{
+		_frames = atoi(argv[1]);
+	}
+
+	// glyphs of a small proportional font (Org_01 like)
+	for (int c = BENCH_FIRST_CHAR; c <= BENCH_LAST_CHAR; c++)
+	{
+		BenchGlyph *g = &_glyphs[c - BENCH_FIRST_CHAR];
+		(*g).width = c == ' ' ? 0 : 1 + c % 5;
+		(*g).height = c == ' ' ? 0 : 4 + c % 2;
+		(*g).xAdvance = (*g).width + 1 + (c == ' ' ? 2 : 0);
+		(*g).xOffset = 0;
+		(*g).yOffset = -(int8_t)(*g).height;
+	}
+
+	ms_layout_reset(&_cache);
+	printf("frames: %d, texts per frame: 12\n", _frames);
+	printf("%-28s %10s\n", "bounds", "ns/frame");
+	printf("%-28s %10.1f\n", "getTextBounds", _bench(false));
+	printf("%-28s %10.1f\n", "ms_layout cache", _bench(true));
+	printf("cache hits: %lu, misses: %lu\n", (unsigned long)_cache.hits, (unsigned long)_cache.misses);
+
+	_check();
+	return 0;
+}
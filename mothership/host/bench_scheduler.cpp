@@ -0,0 +1,514 @@
+// Deterministic benchmark of the Actions engine on the host.
+//
+// Drives groups of synthetic actions shaped like the mothership ones
+// (sensors -> interpret -> outlet with the pump as child, plus the UI
+// and the web server) on a virtual clock. Callbacks advance the clock
+// by a modelled cost, so runs are repeatable and the numbers do not
+// depend on the host.
+//
+//   bench_scheduler [raw|sched] [groups] [simulated seconds]
+//
+// raw   - doQueueActions on every loop iteration (the original loop)
+// sched - ms_sched_run + ms_sched_wait (the tickless loop)
+//
+// Reports passes/sec (wall clock), the share of virtual time spent in
+// callbacks and passes, and the distribution of how late starts, ticks
+// and stops ran compared to the time they were due.
+//
+// The pass line shows what a pass which runs costs: the scheduler only
+// saves the passes where nothing is due (skipped); a pass where anything
+// is due still walks the whole list inside doQueueActions, so its cost
+// grows with the number of actions in either mode.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "host_clock.h"
+#include "modules/actions/actions.h"
+#include "modules/ms_scheduler/ms_scheduler.h"
+
+#define BENCH_MODE_RAW 0
+#define BENCH_MODE_SCHED 1
+
+// actions per group
+#define BENCH_SENSORS 0
+#define BENCH_INTERPRET 1
+#define BENCH_OUTLET_FAR 2
+#define BENCH_OUTLET_MID 3
+#define BENCH_OUTLET_NEAR 4
+#define BENCH_PUMP 5
+#define BENCH_GROUP_SIZE 6
+#define BENCH_OUTLETS_COUNT 3
+
+// actions shared by all groups, after the groups
+#define BENCH_UI 0
+#define BENCH_WIFI 1
+#define BENCH_SHARED_COUNT 2
+
+// the mothership defaults (ms)
+#define BENCH_SENSORS_INTERVAL_WATERING 15000
+#define BENCH_SENSORS_INTERVAL_STANDBY 60000
+#define BENCH_SENSORS_DURATION 10000
+#define BENCH_SENSORS_TICK_INTERVAL 200
+#define BENCH_PUMP_INTERVAL 600000
+#define BENCH_PUMP_DURATION 120000
+
+// modelled cost of the callbacks (us)
+#define BENCH_SENSORS_TICK_US 50
+#define BENCH_INTERPRET_TICK_US 20
+#define BENCH_SWITCH_US 5
+#define BENCH_UI_TICK_US 20000
+#define BENCH_WIFI_TICK_US 200
+
+// modelled cost of a doQueueActions pass per action in the list (ns)
+// and of a loop iteration (us)
+#define BENCH_PASS_NS_PER_ACTION 200
+#define BENCH_LOOP_US 1
+
+// soil moisture model (%); outlets open below the activation
+// value and close above the deactivation one
+#define BENCH_ACTIVATION 30
+#define BENCH_DEACTIVATION 60
+
+// <1ms, <2ms, <5ms, <10ms, <20ms, <50ms, <100ms, >=100ms
+#define BENCH_MISS_BUCKETS 8
+
+struct BenchMisses
+{
+	uint32_t hist[BENCH_MISS_BUCKETS];
+	uint32_t count;
+	int64_t max;
+};
+
+struct BenchGroup
+{
+	int moisture[BENCH_OUTLETS_COUNT];
+};
+
+static const int64_t _missBounds[BENCH_MISS_BUCKETS - 1] = {1000, 2000, 5000, 10000, 20000, 50000, 100000};
+static const char *_phaseNames[MS_SCHED_PHASES_COUNT] = {"start", "tick", "stop"};
+
+static int _mode = BENCH_MODE_SCHED;
+static int _groups = 100;
+static int _count = 0;
+
+static Action *_actions = nullptr;
+static ActionsList _list;
+static BenchGroup *_groupStates = nullptr;
+
+// when each action was scheduled by the benchmark; -1 if it was not
+static int64_t *_scheduledAt = nullptr;
+static int64_t *_lastTickAt = nullptr;
+static bool *_stopRequested = nullptr;
+
+static BenchMisses _misses[MS_SCHED_PHASES_COUNT];
+static int64_t _busy = 0;
+static uint32_t _seed = 1;
+
+static uint32_t _random()
+{
+	_seed = _seed * 1103515245 + 12345;
+	return (_seed >> 16) & 0x7fff;
+}
+
+static int _indexOf(Action *a)
+{
+	return (int)(a - _actions);
+}
+
+static Action *_groupAction(int group, int action)
+{
+	return &_actions[group * BENCH_GROUP_SIZE + action];
+}
+
+static Action *_sharedAction(int action)
+{
+	return &_actions[_groups * BENCH_GROUP_SIZE + action];
+}
+
+static int _groupOf(Action *a)
+{
+	return _indexOf(a) / BENCH_GROUP_SIZE;
+}
+
+static void _cost(int64_t us)
+{
+	host_clock_advance(us);
+	_busy += us;
+}
+
+static void _miss(int phase, int64_t dueAt)
+{
+	int64_t late = host_clock_us() - dueAt;
+	if (late < 0)
+	{
+		late = 0;
+	}
+
+	BenchMisses *m = &_misses[phase];
+	int b = 0;
+	while (b < BENCH_MISS_BUCKETS - 1 && late >= _missBounds[b])
+	{
+		b++;
+	}
+
+	(*m).hist[b]++;
+	(*m).count++;
+	if (late > (*m).max)
+	{
+		(*m).max = late;
+	}
+}
+
+// Engine calls, per mode
+
+static void _schedule(Action *a)
+{
+	int i = _indexOf(a);
+	if ((*a).state == MS_NON_ACTIVE)
+	{
+		_scheduledAt[i] = host_clock_us();
+	}
+
+	if (_mode == BENCH_MODE_SCHED)
+	{
+		ms_sched_schedule(a);
+	}
+	else
+	{
+		scheduleAction(&_list, a);
+	}
+}
+
+static void _stop(Action *a)
+{
+	_stopRequested[_indexOf(a)] = true;
+
+	if (_mode == BENCH_MODE_SCHED)
+	{
+		ms_sched_stop(a);
+	}
+	else
+	{
+		requestStop(&_list, a);
+	}
+}
+
+static void _interpretNow(Action *a)
+{
+	if (_mode == BENCH_MODE_SCHED)
+	{
+		ms_sched_trigger(a, nullptr);
+	}
+	else
+	{
+		_schedule(a);
+	}
+}
+
+// Callbacks
+
+static void _start(Action *a)
+{
+	int i = _indexOf(a);
+	_lastTickAt[i] = host_clock_us();
+
+	if (_scheduledAt[i] >= 0)
+	{
+		int64_t dueAt = _scheduledAt[i];
+		if ((*a).lst != 0 && (int64_t)((*a).lst + (*a).ti) * 1000 > dueAt)
+		{
+			dueAt = (int64_t)((*a).lst + (*a).ti) * 1000;
+		}
+		_miss(MS_SCHED_PHASE_START, dueAt);
+
+		// frozen actions are due again ti after their stop
+		_scheduledAt[i] = (*a).frozen ? 0 : -1;
+	}
+
+	_cost(BENCH_SWITCH_US);
+}
+
+static void _stopped(Action *a)
+{
+	int i = _indexOf(a);
+	if (_stopRequested[i])
+	{
+		_stopRequested[i] = false;
+	}
+	else if ((*a).td > 0)
+	{
+		_miss(MS_SCHED_PHASE_STOP, (int64_t)((*a).st + (*a).td) * 1000);
+	}
+
+	_cost(BENCH_SWITCH_US);
+}
+
+static void _ticked(Action *a, int64_t cost)
+{
+	int i = _indexOf(a);
+	if ((*a).to > 0)
+	{
+		_miss(MS_SCHED_PHASE_TICK, _lastTickAt[i] + (int64_t)(*a).to * 1000);
+	}
+	_lastTickAt[i] = host_clock_us();
+	_cost(cost);
+}
+
+static void _tickNothing(Action *a)
+{
+	_ticked(a, 0);
+}
+
+static void _tickSensors(Action *a)
+{
+	_ticked(a, BENCH_SENSORS_TICK_US);
+}
+
+static void _stopSensors(Action *a)
+{
+	_stopped(a);
+
+	// the soil dries out a little between reads
+	BenchGroup *g = &_groupStates[_groupOf(a)];
+	for (int o = 0; o < BENCH_OUTLETS_COUNT; o++)
+	{
+		(*g).moisture[o] -= _random() % 4;
+	}
+
+	_interpretNow(_groupAction(_groupOf(a), BENCH_INTERPRET));
+}
+
+// the same decisions as tickInterpret: close the outlets which got
+// wet enough, open the first dry one when none is open
+static void _tickInterpret(Action *a)
+{
+	_ticked(a, BENCH_INTERPRET_TICK_US);
+
+	int group = _groupOf(a);
+	BenchGroup *g = &_groupStates[group];
+	Action *open = nullptr;
+	Action *dry = nullptr;
+
+	for (int o = 0; o < BENCH_OUTLETS_COUNT; o++)
+	{
+		Action *outlet = _groupAction(group, BENCH_OUTLET_FAR + o);
+		bool running = (*outlet).state == MS_RUNNING;
+		if (running)
+		{
+			(*g).moisture[o] += 15;
+		}
+
+		if (running && (*g).moisture[o] >= BENCH_DEACTIVATION)
+		{
+			_stop(outlet);
+		}
+		else if (running || (*outlet).state == MS_SCHEDULED)
+		{
+			open = outlet;
+		}
+		else if (dry == nullptr && (*g).moisture[o] < BENCH_ACTIVATION)
+		{
+			dry = outlet;
+		}
+	}
+
+	if (open == nullptr && dry != nullptr)
+	{
+		_schedule(dry);
+	}
+
+	Action *sensors = _groupAction(group, BENCH_SENSORS);
+	bool isPumpOpen = (*_groupAction(group, BENCH_PUMP)).state == MS_CHILD_RUNNING;
+	(*sensors).ti = isPumpOpen ? BENCH_SENSORS_INTERVAL_WATERING : BENCH_SENSORS_INTERVAL_STANDBY;
+	if (_mode == BENCH_MODE_SCHED)
+	{
+		ms_sched_touch(sensors);
+	}
+}
+
+static void _tickUI(Action *a)
+{
+	_ticked(a, BENCH_UI_TICK_US);
+}
+
+static void _tickWifi(Action *a)
+{
+	_ticked(a, BENCH_WIFI_TICK_US);
+}
+
+// Setup
+
+static void _setAction(Action *a, const char *name, bool frozen, unsigned long ti, unsigned long td, unsigned long to, void (*tick)(Action *a))
+{
+	(*a).name = (char *)name;
+	(*a).frozen = frozen;
+	(*a).ti = ti;
+	(*a).td = td;
+	(*a).to = to;
+	(*a).state = MS_NON_ACTIVE;
+	(*a).start = &_start;
+	(*a).tick = tick;
+	(*a).stop = &_stopped;
+	(*a).canStart = nullptr;
+	(*a).child = nullptr;
+	(*a).context = nullptr;
+	(*a).lst = 0;
+	(*a).st = 0;
+}
+
+static void _populate()
+{
+	_count = _groups * BENCH_GROUP_SIZE + BENCH_SHARED_COUNT;
+	_actions = (Action *)calloc(_count, sizeof(Action));
+	_groupStates = (BenchGroup *)calloc(_groups, sizeof(BenchGroup));
+	_scheduledAt = (int64_t *)calloc(_count, sizeof(int64_t));
+	_lastTickAt = (int64_t *)calloc(_count, sizeof(int64_t));
+	_stopRequested = (bool *)calloc(_count, sizeof(bool));
+
+	for (int i = 0; i < _count; i++)
+	{
+		_scheduledAt[i] = -1;
+	}
+
+	for (int g = 0; g < _groups; g++)
+	{
+		_setAction(_groupAction(g, BENCH_SENSORS), "sensors", true, BENCH_SENSORS_INTERVAL_STANDBY, BENCH_SENSORS_DURATION, BENCH_SENSORS_TICK_INTERVAL, &_tickSensors);
+		(*_groupAction(g, BENCH_SENSORS)).stop = &_stopSensors;
+		_setAction(_groupAction(g, BENCH_INTERPRET), "interpret", false, 1, 1, 0, &_tickInterpret);
+		_setAction(_groupAction(g, BENCH_PUMP), "pump", false, 0, 0, 0, &_tickNothing);
+
+		for (int o = 0; o < BENCH_OUTLETS_COUNT; o++)
+		{
+			Action *outlet = _groupAction(g, BENCH_OUTLET_FAR + o);
+			_setAction(outlet, "outlet", false, BENCH_PUMP_INTERVAL, BENCH_PUMP_DURATION, 0, &_tickNothing);
+			(*outlet).child = _groupAction(g, BENCH_PUMP);
+			_groupStates[g].moisture[o] = BENCH_ACTIVATION + (int)(_random() % 60);
+		}
+	}
+
+	_setAction(_sharedAction(BENCH_UI), "ui", true, 1000, 100, 0, &_tickUI);
+	_setAction(_sharedAction(BENCH_WIFI), "wifi", false, 1, 0, 10, &_tickWifi);
+
+	_list.availableActions = _actions;
+	_list.availableActionsCount = _count;
+	initActionsList(_count);
+
+	if (_mode == BENCH_MODE_SCHED)
+	{
+		ms_sched_init(&_list);
+		for (int g = 0; g < _groups; g++)
+		{
+			for (int o = 0; o < BENCH_OUTLETS_COUNT; o++)
+			{
+				ms_sched_set_priority(_groupAction(g, BENCH_OUTLET_FAR + o), MS_SCHED_PRIORITY_CRITICAL);
+			}
+			ms_sched_set_priority(_groupAction(g, BENCH_PUMP), MS_SCHED_PRIORITY_CRITICAL);
+		}
+		ms_sched_set_priority(_sharedAction(BENCH_UI), MS_SCHED_PRIORITY_BEST_EFFORT);
+		ms_sched_set_priority(_sharedAction(BENCH_WIFI), MS_SCHED_PRIORITY_BEST_EFFORT);
+	}
+
+	_schedule(_sharedAction(BENCH_UI));
+	_schedule(_sharedAction(BENCH_WIFI));
+}
+
+// the groups start reading their sensors spread over one standby interval
+static unsigned long _groupStartsAt(int group)
+{
+	return (unsigned long)((int64_t)BENCH_SENSORS_INTERVAL_STANDBY * group / _groups);
+}
+
+static void _report(unsigned long simulated, uint64_t iterations, uint64_t passes, double wall, double passWall)
+{
+	printf("mode: %s\n", _mode == BENCH_MODE_SCHED ? "sched" : "raw");
+	printf("actions: %d (%d groups)\n", _count, _groups);
+	printf("simulated: %lu s, wall: %.3f s\n", simulated, wall);
+	printf("loop iterations: %llu\n", (unsigned long long)iterations);
+	printf("passes: %llu, %.0f passes/s\n", (unsigned long long)passes, wall > 0 ? passes / wall : 0.0);
+	printf("pass: %d actions walked, %.1f us modelled, %.2f us wall; skipped: %llu\n", _count, (double)_count * BENCH_PASS_NS_PER_ACTION / 1000, passes > 0 ? passWall * 1000000 / passes : 0.0, (unsigned long long)(iterations - passes));
+	printf("busy: %.2f%% of simulated time\n", 100.0 * _busy / ((int64_t)simulated * 1000000));
+	printf("lateness      <1ms     <2ms     <5ms    <10ms    <20ms    <50ms   <100ms  >=100ms      max(us)\n");
+
+	for (int p = 0; p < MS_SCHED_PHASES_COUNT; p++)
+	{
+		BenchMisses *m = &_misses[p];
+		printf("%-8s", _phaseNames[p]);
+		for (int b = 0; b < BENCH_MISS_BUCKETS; b++)
+		{
+			printf(" %8u", (*m).hist[b]);
+		}
+		printf(" %12lld\n", (long long)(*m).max);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long simulated = 600;
+
+	if (argc > 1)
+	{
+		_mode = strcmp(argv[1], "raw") == 0 ? BENCH_MODE_RAW : BENCH_MODE_SCHED;
+	}
+	if (argc > 2)
+	{
+		_groups = atoi(argv[2]) > 0 ? atoi(argv[2]) : 1;
+	}
+	if (argc > 3)
+	{
+		simulated = strtoul(argv[3], nullptr, 10);
+	}
+
+	_populate();
+
+	int64_t passCost = (int64_t)_count * BENCH_PASS_NS_PER_ACTION / 1000;
+	int64_t end = (int64_t)simulated * 1000000;
+	uint64_t iterations = 0;
+	uint64_t passes = 0;
+	double passWall = 0;
+	int nextGroup = 0;
+
+	auto startedAt = std::chrono::steady_clock::now();
+
+	while (host_clock_us() < end)
+	{
+		unsigned long now = host_clock_ms();
+		while (nextGroup < _groups && now >= _groupStartsAt(nextGroup))
+		{
+			_schedule(_groupAction(nextGroup, BENCH_SENSORS));
+			nextGroup++;
+		}
+
+		bool ran = true;
+		auto passStartedAt = std::chrono::steady_clock::now();
+		if (_mode == BENCH_MODE_SCHED)
+		{
+			ran = ms_sched_run(host_clock_us());
+		}
+		else
+		{
+			doQueueActions(&_list, now);
+		}
+
+		if (ran)
+		{
+			passWall += std::chrono::duration<double>(std::chrono::steady_clock::now() - passStartedAt).count();
+			_cost(passCost);
+			passes++;
+		}
+
+		if (_mode == BENCH_MODE_SCHED)
+		{
+			ms_sched_wait(host_clock_us());
+		}
+
+		host_clock_advance(BENCH_LOOP_US);
+		iterations++;
+	}
+
+	double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - startedAt).count();
+	_report(simulated, iterations, passes, wall, passWall);
+
+	return 0;
+}
@@ -0,0 +1,40 @@
+#include "host_clock.h"
+#include "esp_timer.h"
+
+static int64_t _now = 0;
+static bool _notified = false;
+
+int64_t host_clock_us()
+{
+	return _now;
+}
+
+unsigned long host_clock_ms()
+{
+	return (unsigned long)(_now / 1000);
+}
+
+void host_clock_advance(int64_t us)
+{
+	if (us > 0)
+	{
+		_now += us;
+	}
+}
+
+void host_clock_notify()
+{
+	_notified = true;
+}
+
+bool host_clock_take_notification()
+{
+	bool notified = _notified;
+	_notified = false;
+	return notified;
+}
+
+int64_t esp_timer_get_time()
+{
+	return _now;
+}
@@ -0,0 +1,8 @@
+#ifndef _HOST_ESP_TIMER_h
+#define _HOST_ESP_TIMER_h
+#include <stdint.h>
+
+// microseconds of the virtual clock
+int64_t esp_timer_get_time();
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef _HOST_FREERTOS_h
+#define _HOST_FREERTOS_h
+#include <stdint.h>
+
+// Single threaded stand-ins for the parts of FreeRTOS the scheduler
+// uses. There is only one task, so critical sections are no-ops.
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef void *TaskHandle_t;
+typedef void *QueueHandle_t;
+typedef int portMUX_TYPE;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+
+#define portTICK_PERIOD_MS 1
+#define portMAX_DELAY 0xffffffffUL
+#define portNUM_PROCESSORS 2
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) (void)(mux)
+#define portEXIT_CRITICAL(mux) (void)(mux)
+#define portENTER_CRITICAL_ISR(mux) (void)(mux)
+#define portEXIT_CRITICAL_ISR(mux) (void)(mux)
+#define portYIELD_FROM_ISR(woken) (void)(woken)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms) / portTICK_PERIOD_MS)
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef _HOST_FREERTOS_QUEUE_h
+#define _HOST_FREERTOS_QUEUE_h
+#include "freertos/FreeRTOS.h"
+
+inline QueueHandle_t xQueueCreate(int length, int size)
+{
+	return nullptr;
+}
+
+inline void vQueueDelete(QueueHandle_t queue)
+{
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+	return pdFAIL;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+	return pdFAIL;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _HOST_FREERTOS_TASK_h
+#define _HOST_FREERTOS_TASK_h
+#include "freertos/FreeRTOS.h"
+#include "host_clock.h"
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+	static int loopTask;
+	return &loopTask;
+}
+
+inline void xTaskNotifyGive(TaskHandle_t task)
+{
+	host_clock_notify();
+}
+
+inline void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+	host_clock_notify();
+}
+
+// a pending notification returns right away, otherwise the
+// whole timeout passes on the virtual clock
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+	if (host_clock_take_notification())
+	{
+		return 1;
+	}
+
+	host_clock_advance((int64_t)ticks * portTICK_PERIOD_MS * 1000);
+	return 0;
+}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+	host_clock_advance((int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+// no other tasks on the host; worker bound actions stay on the loop task
+inline BaseType_t xTaskCreatePinnedToCore(void (*task)(void *), const char *name, uint32_t stack, void *param, int priority, TaskHandle_t *handle, int core)
+{
+	return pdFAIL;
+}
+
+#endif
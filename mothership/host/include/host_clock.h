@@ -0,0 +1,17 @@
+#ifndef _HOST_CLOCK_h
+#define _HOST_CLOCK_h
+#include <stdint.h>
+
+// Virtual clock of the host build. Time only moves when the simulation
+// says so: callbacks advance it by their modelled cost and a blocked
+// loop task (ulTaskNotifyTake, vTaskDelay) jumps it to its wake up time.
+
+int64_t host_clock_us();
+unsigned long host_clock_ms();
+void host_clock_advance(int64_t us);
+
+// set by xTaskNotifyGive; consumed by ulTaskNotifyTake
+void host_clock_notify();
+bool host_clock_take_notification();
+
+#endif
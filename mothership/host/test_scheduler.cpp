@@ -0,0 +1,415 @@
+// Host tests of the scheduler front end on the virtual clock.
+//
+//   test_scheduler end       - a frozen action shaped like the sensors
+//                              read (ti, a long td and a tick every to
+//                              ms) ends its run early with ms_sched_end,
+//                              as tickSensors does once the sensors
+//                              settled. Every following run has to come
+//                              due ti after the previous one ended - the
+//                              action must stay in the list and the heap.
+//   test_scheduler tick_now  - an action ticked when it has work (to = 0,
+//                              a long tick interval, as the BLE action)
+//                              ticks right after ms_sched_tick_now and
+//                              the loop sleeps in between.
+//   test_scheduler priority  - a critical action stops in the same pass
+//                              as a slow tick of a normal action earlier
+//                              in the list; the stop has to run first
+//                              and within MS_SCHED_STOP_LATENCY_BOUND_US.
+//   test_scheduler wrap      - the end test started 2.5 s before the 32 bit
+//                              millisecond clock of the library wraps
+//                              (49.7 days), so runs, ticks and stops
+//                              cross it.
+//   test_scheduler trigger   - an action triggered while canStart refuses
+//                              runs once it is admitted, with the payload
+//                              of the latest trigger; the payload is gone
+//                              after that run and a regular run ticks
+//                              without it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_clock.h"
+#include "modules/actions/actions.h"
+#include "modules/ms_scheduler/ms_scheduler.h"
+
+#define TEST_INTERVAL 1000
+#define TEST_DURATION 10000
+#define TEST_TICK_INTERVAL 200
+// ticks of a run before it is ended
+#define TEST_TICKS_PER_RUN 2
+#define TEST_RUNS 5
+// the loop polls deadlines closer than one RTOS tick
+#define TEST_TOLERANCE_US 2000
+
+#define TEST_IDLE_TICK_US 1000000
+#define TEST_WAKES 5
+// virtual time between the wakes
+#define TEST_WAKE_GAP_US 50000
+
+// 2.5 s before 2^32 ms; with the second _init adds, a run
+// is ended and stopped right after the wrap
+#define TEST_WRAP_START_US ((int64_t)(4294967296LL - 2500) * 1000)
+
+#define TEST_SLOW_TICK_US 30000
+#define TEST_SLOW_INTERVAL 100
+#define TEST_STOPS 5
+
+static Action _actions[2];
+static ActionsList _list;
+
+static int _runs = 0;
+static int _ticks = 0;
+static int64_t _startedAt[TEST_RUNS + 1];
+static int64_t _stoppedAt[TEST_RUNS + 1];
+static int64_t _tickedAt[TEST_WAKES + 1];
+static int _failures = 0;
+
+static void _check(bool condition, const char *what, int run)
+{
+	if (!condition)
+	{
+		fprintf(stderr, "FAIL (%d): %s\n", run, what);
+		_failures++;
+	}
+}
+
+static void _nothing(Action *a)
+{
+}
+
+static void _setAction(int index, unsigned long ti, unsigned long td, unsigned long to, void (*start)(Action *a), void (*tick)(Action *a), void (*stop)(Action *a))
+{
+	Action *a = &_actions[index];
+	memset(a, 0, sizeof(Action));
+	(*a).frozen = true;
+	(*a).name = (char *)"test";
+	(*a).ti = ti;
+	(*a).td = td;
+	(*a).to = to;
+	(*a).state = MS_NON_ACTIVE;
+	(*a).start = start;
+	(*a).tick = tick;
+	(*a).stop = stop;
+}
+
+static void _init(int count)
+{
+	_list.availableActions = _actions;
+	_list.availableActionsCount = count;
+	initActionsList(count);
+	ms_sched_init(&_list);
+
+	// keep clear of the 0 stamps the library treats as never
+	host_clock_advance(1000000);
+}
+
+// passes which had work to do
+static int _passes = 0;
+
+static void _loop()
+{
+	if (ms_sched_run(host_clock_us()))
+	{
+		_passes++;
+	}
+	ms_sched_wait(host_clock_us());
+	host_clock_advance(10);
+}
+
+// ms_sched_end
+
+// st as stamped by the library at the start of the run
+static unsigned long _stamp = 0;
+
+static void _startRun(Action *a)
+{
+	if (_runs <= TEST_RUNS)
+	{
+		_startedAt[_runs] = host_clock_us();
+	}
+	_ticks = 0;
+	_stamp = (*a).st;
+}
+
+static void _tickRun(Action *a)
+{
+	if (++_ticks == TEST_TICKS_PER_RUN)
+	{
+		ms_sched_end(a);
+	}
+}
+
+static void _stopRun(Action *a)
+{
+	_check((*a).st == _stamp, "the start stamp of the library was changed", _runs);
+	if (_runs <= TEST_RUNS)
+	{
+		_stoppedAt[_runs] = host_clock_us();
+	}
+	_runs++;
+}
+
+static void _testEnd()
+{
+	_setAction(0, TEST_INTERVAL, TEST_DURATION, TEST_TICK_INTERVAL, &_startRun, &_tickRun, &_stopRun);
+	_init(1);
+	ms_sched_schedule(&_actions[0]);
+
+	int64_t end = host_clock_us() + (int64_t)(TEST_RUNS + 1) * (TEST_INTERVAL + TEST_TICKS_PER_RUN * TEST_TICK_INTERVAL) * 1000;
+	while (host_clock_us() < end && _runs <= TEST_RUNS)
+	{
+		_loop();
+	}
+
+	_check(_runs > TEST_RUNS, "the action did not come due again after being ended", _runs);
+	_check(_actions[0].td == TEST_DURATION, "the duration cut by ms_sched_end was not restored", (int)_actions[0].td);
+	for (int r = 0; r < _runs && r <= TEST_RUNS; r++)
+	{
+		int64_t ran = _stoppedAt[r] - _startedAt[r];
+		_check(ran < (int64_t)TEST_DURATION * 1000, "the run was not ended early", r);
+		_check(ran <= (int64_t)TEST_TICKS_PER_RUN * TEST_TICK_INTERVAL * 1000 + TEST_TOLERANCE_US, "the run was not ended right after its tick", r);
+
+		if (r > 0)
+		{
+			int64_t gap = _startedAt[r] - _stoppedAt[r - 1];
+			_check(gap >= (int64_t)TEST_INTERVAL * 1000, "the next run started before ti", r);
+			_check(gap <= (int64_t)TEST_INTERVAL * 1000 + TEST_TOLERANCE_US, "the next run did not start ti after the end", r);
+		}
+	}
+
+	_check(_passes <= (TEST_RUNS + 1) * (TEST_TICKS_PER_RUN + 2) * 2, "the loop did not sleep between the passes", _passes);
+	if (_failures == 0)
+	{
+		printf("ok: %d runs ended early, each next one due ti later\n", _runs);
+	}
+}
+
+// ms_sched_tick_now
+
+static void _tickWork(Action *a)
+{
+	if (_ticks <= TEST_WAKES)
+	{
+		_tickedAt[_ticks] = host_clock_us();
+	}
+	_ticks++;
+}
+
+static void _testTickNow()
+{
+	_setAction(0, 1, 0, 0, &_nothing, &_tickWork, &_nothing);
+	_init(1);
+	ms_sched_set_tick_interval(&_actions[0], TEST_IDLE_TICK_US);
+	ms_sched_schedule(&_actions[0]);
+
+	// the start and the first tick after the idle interval
+	while (true)
+	{
+		ms_sched_run(host_clock_us());
+		if (_ticks > 0)
+		{
+			break;
+		}
+		ms_sched_wait(host_clock_us());
+	}
+
+	for (int w = 1; w <= TEST_WAKES; w++)
+	{
+		// nothing to do: the loop would sleep for the idle interval
+		host_clock_advance(TEST_WAKE_GAP_US);
+		ms_sched_run(host_clock_us());
+		_check(_ticks == w, "the action ticked without being woken", w);
+		_check(ms_sched_next_deadline(host_clock_us()) - host_clock_us() > TEST_WAKE_GAP_US, "the loop would not sleep", w);
+
+		ms_sched_tick_now(&_actions[0]);
+		int64_t wokenAt = host_clock_us();
+		_check(ms_sched_next_deadline(wokenAt) == wokenAt, "the tick is not due right away", w);
+		ms_sched_run(host_clock_us());
+		_check(_ticks == w + 1, "the action did not tick right after ms_sched_tick_now", w);
+		_check(_tickedAt[w] - wokenAt <= TEST_TOLERANCE_US, "the tick came late", w);
+	}
+
+	// the idle interval bounds the wait when nothing wakes it
+	int ticks = _ticks;
+	int64_t end = host_clock_us() + TEST_IDLE_TICK_US + TEST_TOLERANCE_US;
+	while (host_clock_us() < end)
+	{
+		_loop();
+	}
+	_check(_ticks == ticks + 1, "the action did not tick once per idle interval", 0);
+
+	if (_failures == 0)
+	{
+		printf("ok: %d ticks right after ms_sched_tick_now\n", TEST_WAKES);
+	}
+}
+
+// priority classes
+
+static int _stops = 0;
+// the slow tick ran after the critical stop of the same pass
+static int _stopsFirst = 0;
+static int64_t _stoppedAtPass = -1;
+
+static void _tickSlow(Action *a)
+{
+	if (_stoppedAtPass >= 0 && _stoppedAtPass / 1000 == host_clock_us() / 1000)
+	{
+		_stopsFirst++;
+	}
+	host_clock_advance(TEST_SLOW_TICK_US);
+}
+
+static void _stopCritical(Action *a)
+{
+	_stoppedAtPass = host_clock_us();
+	_stops++;
+}
+
+static void _testPriority()
+{
+	// the stop of the critical action comes due together with a tick of
+	// the slow one, which the library walks first
+	_setAction(0, 1, 0, TEST_SLOW_INTERVAL, &_nothing, &_tickSlow, &_nothing);
+	_setAction(1, 1, TEST_SLOW_INTERVAL, 0, &_nothing, &_nothing, &_stopCritical);
+	_actions[1].frozen = false;
+	_init(2);
+	ms_sched_set_priority(&_actions[1], MS_SCHED_PRIORITY_CRITICAL);
+
+	for (int r = 0; r < TEST_STOPS; r++)
+	{
+		int stops = _stops;
+		ms_sched_schedule(&_actions[0]);
+		ms_sched_schedule(&_actions[1]);
+
+		int64_t end = host_clock_us() + (int64_t)TEST_SLOW_INTERVAL * 4000;
+		while (host_clock_us() < end && _stops == stops)
+		{
+			_loop();
+		}
+		_check(_stops == stops + 1, "the critical action did not stop", r);
+		ms_sched_stop(&_actions[0]);
+		_loop();
+
+		// past ti of both, so the next round starts them in one pass
+		host_clock_advance(10000);
+	}
+
+	const MSSchedStats *stats = ms_sched_stats(&_actions[1]);
+	_check(_stopsFirst == TEST_STOPS, "a slow tick ran before the critical stop due in the same pass", _stopsFirst);
+	_check((*stats).stopLate == 0, "a critical stop exceeded MS_SCHED_STOP_LATENCY_BOUND_US", (int)(*stats).stopLate);
+	_check((*stats).stopMax <= MS_SCHED_STOP_LATENCY_BOUND_US, "the longest critical stop exceeded the bound", (int)(*stats).stopMax);
+
+	if (_failures == 0)
+	{
+		printf("ok: %d critical stops before the slow ticks, at most %u us late\n", _stops, (unsigned)(*stats).stopMax);
+	}
+}
+
+// ms_sched_trigger
+
+static bool _admitted = false;
+static int _payloadA = 1;
+static int _payloadB = 2;
+static void *_seen = nullptr;
+
+static bool _admit(Action *a)
+{
+	return _admitted;
+}
+
+static void _tickPayload(Action *a)
+{
+	_seen = ms_sched_payload(a);
+	_ticks++;
+}
+
+static void _stopPayload(Action *a)
+{
+	_runs++;
+}
+
+static void _runUntilStopped(int runs)
+{
+	int64_t end = host_clock_us() + (int64_t)TEST_DURATION * 1000;
+	while (host_clock_us() < end && _runs == runs)
+	{
+		_loop();
+	}
+}
+
+static void _testTrigger()
+{
+	_setAction(0, 1, 5, 0, &_nothing, &_tickPayload, &_stopPayload);
+	_actions[0].frozen = false;
+	_actions[0].canStart = &_admit;
+	_init(1);
+
+	ms_sched_trigger(&_actions[0], &_payloadA);
+	for (int p = 0; p < 10; p++)
+	{
+		_loop();
+	}
+	_check(_ticks == 0, "the action ran while canStart refused", _ticks);
+
+	// a newer trigger replaces the payload instead of adding a run
+	ms_sched_trigger(&_actions[0], &_payloadB);
+	_loop();
+	_admitted = true;
+	_runUntilStopped(0);
+	_check(_runs == 1, "the triggered action did not run once admitted", _runs);
+	_check(_seen == &_payloadB, "the run did not tick with the latest payload", 0);
+	_check(ms_sched_payload(&_actions[0]) == nullptr, "the payload outlived the run it was handed to", 0);
+
+	// a regular run must not see a payload already used
+	ms_sched_schedule(&_actions[0]);
+	_runUntilStopped(1);
+	_check(_runs == 2, "the scheduled run did not happen", _runs);
+	_check(_seen == nullptr, "a regular run ticked with a used payload", 0);
+
+	// and nothing runs again on its own
+	int ticks = _ticks;
+	for (int p = 0; p < 100; p++)
+	{
+		_loop();
+	}
+	_check(_ticks == ticks && _runs == 2, "the triggered action ran again", _runs);
+
+	if (_failures == 0)
+	{
+		printf("ok: the triggered run ticked with the latest payload, no run after it did\n");
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *test = argc > 1 ? argv[1] : "end";
+	if (strcmp(test, "end") == 0)
+	{
+		_testEnd();
+	}
+	else if (strcmp(test, "tick_now") == 0)
+	{
+		_testTickNow();
+	}
+	else if (strcmp(test, "priority") == 0)
+	{
+		_testPriority();
+	}
+	else if (strcmp(test, "wrap") == 0)
+	{
+		host_clock_advance(TEST_WRAP_START_US);
+		_testEnd();
+	}
+	else if (strcmp(test, "trigger") == 0)
+	{
+		_testTrigger();
+	}
+	else
+	{
+		fprintf(stderr, "unknown test %s\n", test);
+		return 1;
+	}
+
+	return _failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,426 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "ms_adc.h"
+
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define MS_ADC_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define MS_ADC_GET_CHANNEL(data) ((data)->type1.channel)
+#define MS_ADC_GET_DATA(data) ((data)->type1.data)
+#else
+#define MS_ADC_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define MS_ADC_GET_CHANNEL(data) ((data)->type2.channel)
+#define MS_ADC_GET_DATA(data) ((data)->type2.data)
+#endif
+
+struct MSAdcChannel
+{
+	int pin;
+	adc_channel_t channel;
+	uint16_t ring[MS_ADC_RING_SIZE];
+	int head;	  // next write position
+	int size;	  // samples in the ring
+	uint32_t sum; // of the samples in the ring
+	uint16_t latest;
+	MSFilter filter;
+	adc_cali_handle_t cali; // nullptr - no calibration scheme/eFuse data
+};
+
+static adc_continuous_handle_t _handle = nullptr;
+static adc_oneshot_unit_handle_t _oneshot = nullptr;
+static MSAdcChannel _channels[MS_ADC_CHANNELS_MAX];
+static int _channelsCount = 0;
+static bool _running = false;
+
+// guards the rings; collect and the readers run on different tasks
+static SemaphoreHandle_t _lock = nullptr;
+static uint8_t _frame[MS_ADC_FRAME_SIZE];
+static volatile uint32_t _overflows = 0;
+
+static bool IRAM_ATTR _onPoolOverflow(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *data, void *context)
+{
+	_overflows++;
+	return false;
+}
+
+static MSAdcChannel *_findPin(int pin)
+{
+	for (int i = 0; i < _channelsCount; i++)
+	{
+		if (_channels[i].pin == pin)
+		{
+			return &_channels[i];
+		}
+	}
+	return nullptr;
+}
+
+static MSAdcChannel *_findChannel(uint32_t channel)
+{
+	for (int i = 0; i < _channelsCount; i++)
+	{
+		if ((uint32_t)_channels[i].channel == channel)
+		{
+			return &_channels[i];
+		}
+	}
+	return nullptr;
+}
+
+static void _push(MSAdcChannel *c, uint16_t value)
+{
+	if ((*c).size == MS_ADC_RING_SIZE)
+	{
+		(*c).sum -= (*c).ring[(*c).head];
+	}
+	else
+	{
+		(*c).size++;
+	}
+
+	(*c).ring[(*c).head] = value;
+	(*c).sum += value;
+	(*c).head = ((*c).head + 1) % MS_ADC_RING_SIZE;
+	(*c).latest = value;
+	ms_filter_push(&(*c).filter, value);
+}
+
+static adc_cali_handle_t _createCali(adc_channel_t channel)
+{
+	adc_cali_handle_t cali = nullptr;
+
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+	adc_cali_curve_fitting_config_t config = {};
+	config.unit_id = ADC_UNIT_1;
+	config.chan = channel;
+	config.atten = ADC_ATTEN_DB_11;
+	config.bitwidth = ADC_BITWIDTH_DEFAULT;
+	if (adc_cali_create_scheme_curve_fitting(&config, &cali) != ESP_OK)
+	{
+		cali = nullptr;
+	}
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+	adc_cali_line_fitting_config_t config = {};
+	config.unit_id = ADC_UNIT_1;
+	config.atten = ADC_ATTEN_DB_11;
+	config.bitwidth = ADC_BITWIDTH_DEFAULT;
+	if (adc_cali_create_scheme_line_fitting(&config, &cali) != ESP_OK)
+	{
+		cali = nullptr;
+	}
+#endif
+
+	return cali;
+}
+
+// Single conversions while the sampler is stopped
+static bool _initOneshot()
+{
+	adc_oneshot_unit_init_cfg_t unitConfig = {};
+	unitConfig.unit_id = ADC_UNIT_1;
+	if (adc_oneshot_new_unit(&unitConfig, &_oneshot) != ESP_OK)
+	{
+		ESP_LOGE(MS_ADC_TAG, "Unable to create the oneshot ADC unit");
+		_oneshot = nullptr;
+		return false;
+	}
+
+	adc_oneshot_chan_cfg_t channelConfig = {};
+	channelConfig.atten = ADC_ATTEN_DB_11;
+	channelConfig.bitwidth = ADC_BITWIDTH_DEFAULT;
+	for (int i = 0; i < _channelsCount; i++)
+	{
+		if (adc_oneshot_config_channel(_oneshot, _channels[i].channel, &channelConfig) != ESP_OK)
+		{
+			ESP_LOGE(MS_ADC_TAG, "Unable to configure pin %d", _channels[i].pin);
+			adc_oneshot_del_unit(_oneshot);
+			_oneshot = nullptr;
+			return false;
+		}
+		_channels[i].cali = _createCali(_channels[i].channel);
+	}
+
+	return true;
+}
+
+// DMA conversions of all pins while the sampler runs
+static bool _initContinuous()
+{
+	adc_digi_pattern_config_t pattern[MS_ADC_CHANNELS_MAX] = {};
+	for (int i = 0; i < _channelsCount; i++)
+	{
+		pattern[i].atten = ADC_ATTEN_DB_11;
+		pattern[i].channel = _channels[i].channel & 0x7;
+		pattern[i].unit = ADC_UNIT_1;
+		pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+	}
+
+	adc_continuous_handle_cfg_t handleConfig = {};
+	handleConfig.max_store_buf_size = MS_ADC_POOL_SIZE;
+	handleConfig.conv_frame_size = MS_ADC_FRAME_SIZE;
+	if (adc_continuous_new_handle(&handleConfig, &_handle) != ESP_OK)
+	{
+		ESP_LOGE(MS_ADC_TAG, "Unable to create the continuous ADC handle");
+		_handle = nullptr;
+		return false;
+	}
+
+	adc_continuous_config_t config = {};
+	config.pattern_num = _channelsCount;
+	config.adc_pattern = pattern;
+	config.sample_freq_hz = MS_ADC_SAMPLE_FREQ_HZ;
+	config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+	config.format = MS_ADC_OUTPUT_FORMAT;
+
+	adc_continuous_evt_cbs_t callbacks = {};
+	callbacks.on_pool_ovf = &_onPoolOverflow;
+
+	if (adc_continuous_config(_handle, &config) != ESP_OK || adc_continuous_register_event_callbacks(_handle, &callbacks, nullptr) != ESP_OK)
+	{
+		ESP_LOGE(MS_ADC_TAG, "Unable to configure the continuous ADC");
+		adc_continuous_deinit(_handle);
+		_handle = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+// Registers the pins (ADC1 only) and configures the drivers. Single
+// reads (ms_adc_read) work right away; sampling starts with
+// ms_adc_start. Returns false if the pins cannot be read at all - a
+// failing sampler only means ms_adc_start will fail.
+bool ms_adc_init(const int *pins, int count)
+{
+	if (count <= 0 || count > MS_ADC_CHANNELS_MAX)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		adc_unit_t unit;
+		adc_channel_t channel;
+		if (adc_continuous_io_to_channel(pins[i], &unit, &channel) != ESP_OK || unit != ADC_UNIT_1)
+		{
+			ESP_LOGE(MS_ADC_TAG, "Pin %d is not an ADC1 pin", pins[i]);
+			return false;
+		}
+
+		memset(&_channels[i], 0, sizeof(MSAdcChannel));
+		_channels[i].pin = pins[i];
+		_channels[i].channel = channel;
+		ms_filter_init(&_channels[i].filter, MS_ADC_FILTER_MODE, MS_ADC_FILTER_SIZE, MS_ADC_FILTER_TRIM);
+	}
+	_channelsCount = count;
+
+	if (!_initOneshot())
+	{
+		_channelsCount = 0;
+		return false;
+	}
+
+	_initContinuous();
+	_lock = xSemaphoreCreateMutex();
+	return true;
+}
+
+// Replaces the filter of the pin; the window starts empty
+bool ms_adc_set_filter(int pin, int mode, int size, int trim)
+{
+	MSAdcChannel *c = _findPin(pin);
+	if (c == nullptr || _lock == nullptr)
+	{
+		return false;
+	}
+
+	xSemaphoreTake(_lock, portMAX_DELAY);
+	ms_filter_init(&(*c).filter, mode, size, trim);
+	xSemaphoreGive(_lock);
+
+	return true;
+}
+
+bool ms_adc_start()
+{
+	if (_handle == nullptr || _running)
+	{
+		return _running;
+	}
+
+	xSemaphoreTake(_lock, portMAX_DELAY);
+	for (int i = 0; i < _channelsCount; i++)
+	{
+		_channels[i].head = 0;
+		_channels[i].size = 0;
+		_channels[i].sum = 0;
+		ms_filter_reset(&_channels[i].filter);
+	}
+	xSemaphoreGive(_lock);
+
+	_running = adc_continuous_start(_handle) == ESP_OK;
+	return _running;
+}
+
+void ms_adc_stop()
+{
+	if (_running)
+	{
+		_running = false;
+		adc_continuous_stop(_handle);
+	}
+}
+
+bool ms_adc_running()
+{
+	return _running;
+}
+
+// Moves everything converted since the last call into the rings;
+// returns the number of samples collected
+int ms_adc_collect()
+{
+	if (!_running)
+	{
+		return 0;
+	}
+
+	int collected = 0;
+	uint32_t length = 0;
+
+	xSemaphoreTake(_lock, portMAX_DELAY);
+	while (adc_continuous_read(_handle, _frame, MS_ADC_FRAME_SIZE, &length, 0) == ESP_OK)
+	{
+		for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES)
+		{
+			adc_digi_output_data_t *data = (adc_digi_output_data_t *)&_frame[i];
+			MSAdcChannel *c = _findChannel(MS_ADC_GET_CHANNEL(data));
+			if (c != nullptr)
+			{
+				_push(c, (uint16_t)MS_ADC_GET_DATA(data));
+				collected++;
+			}
+		}
+	}
+	xSemaphoreGive(_lock);
+
+	return collected;
+}
+
+// Mean of the samples of the pin kept in its ring
+bool ms_adc_mean(int pin, int *target)
+{
+	MSAdcChannel *c = _findPin(pin);
+	if (c == nullptr || _lock == nullptr)
+	{
+		return false;
+	}
+
+	bool found = false;
+	xSemaphoreTake(_lock, portMAX_DELAY);
+	if ((*c).size > 0)
+	{
+		(*target) = (int)((*c).sum / (*c).size);
+		found = true;
+	}
+	xSemaphoreGive(_lock);
+
+	return found;
+}
+
+// Output of the pin's filter over its most recent samples
+bool ms_adc_filtered(int pin, int *target)
+{
+	MSAdcChannel *c = _findPin(pin);
+	if (c == nullptr || _lock == nullptr)
+	{
+		return false;
+	}
+
+	xSemaphoreTake(_lock, portMAX_DELAY);
+	bool found = ms_filter_value(&(*c).filter, target);
+	xSemaphoreGive(_lock);
+
+	return found;
+}
+
+bool ms_adc_latest(int pin, int *target)
+{
+	MSAdcChannel *c = _findPin(pin);
+	if (c == nullptr || _lock == nullptr)
+	{
+		return false;
+	}
+
+	bool found = false;
+	xSemaphoreTake(_lock, portMAX_DELAY);
+	if ((*c).size > 0)
+	{
+		(*target) = (*c).latest;
+		found = true;
+	}
+	xSemaphoreGive(_lock);
+
+	return found;
+}
+
+// Whether the pin is registered, i.e. owned by the module
+bool ms_adc_has_pin(int pin)
+{
+	return _findPin(pin) != nullptr;
+}
+
+// A single conversion of the pin; while the sampler runs (and owns the
+// unit) the latest sample it collected. Right after ms_adc_start the
+// rings are empty, so this waits up to MS_ADC_FIRST_SAMPLE_MS for the
+// first frame; false if none arrived
+bool ms_adc_read(int pin, int *target)
+{
+	MSAdcChannel *c = _findPin(pin);
+	if (c == nullptr || _oneshot == nullptr)
+	{
+		return false;
+	}
+
+	if (_running)
+	{
+		TickType_t startedAt = xTaskGetTickCount();
+		ms_adc_collect();
+		while (!ms_adc_latest(pin, target))
+		{
+			if (xTaskGetTickCount() - startedAt >= pdMS_TO_TICKS(MS_ADC_FIRST_SAMPLE_MS))
+			{
+				return false;
+			}
+			vTaskDelay(1);
+			ms_adc_collect();
+		}
+		return true;
+	}
+
+	return adc_oneshot_read(_oneshot, (*c).channel, target) == ESP_OK;
+}
+
+// Converts a raw reading of the pin to calibrated millivolts
+bool ms_adc_to_mv(int pin, int raw, int *target)
+{
+	MSAdcChannel *c = _findPin(pin);
+	if (c == nullptr || (*c).cali == nullptr)
+	{
+		return false;
+	}
+
+	return adc_cali_raw_to_voltage((*c).cali, raw, target) == ESP_OK;
+}
+
+uint32_t ms_adc_overflows()
+{
+	return _overflows;
+}
@@ -0,0 +1,76 @@
+#ifndef _MS_ADC_h
+#define _MS_ADC_h
+#include <stdint.h>
+#include "soc/soc_caps.h"
+#include "modules/ms_filter/ms_filter.h"
+
+// Access to the analog inputs.
+//
+// Pins are read through the IDF oneshot driver with a calibration
+// handle per channel, created once at init (ms_adc_read, ms_adc_to_mv).
+// Unlike analogRead this needs no ADC2 register workaround per read.
+//
+// Between ms_adc_start and ms_adc_stop the pins are sampled
+// continuously (DMA): the ADC digital controller converts all of them
+// in a round robin pattern into the driver's pool without any CPU
+// involvement. ms_adc_collect drains the pool into a ring buffer per
+// pin, and the readers only reduce what is already there. The pool holds
+// two MS_ADC_COLLECT_PERIOD_MS periods of conversions, so a collect can
+// be a full period late before the newest conversions are dropped
+// (counted in ms_adc_overflows).
+//
+// Besides the raw ring every pin feeds a streaming filter (ms_filter),
+// by default a trimmed mean which drops the relay switching spikes
+// the plain mean of the ring averages in (ms_adc_filtered).
+//
+// The module owns ADC1 - analogRead on ADC1 pins fails, so every ADC1
+// pin the application reads must be registered and read through
+// ms_adc_read. While the sampler runs ms_adc_read returns the latest
+// sample it collected, waiting for the first frame after a start.
+
+#define MS_ADC_TAG "ms_adc"
+
+// maximum number of sampled pins
+#define MS_ADC_CHANNELS_MAX 8
+
+// conversions per second over all pins
+#define MS_ADC_SAMPLE_FREQ_HZ 20000
+
+// bytes read from the driver at once
+#define MS_ADC_FRAME_SIZE 256
+
+// how often ms_adc_collect is called (the sensors action's to)
+#define MS_ADC_COLLECT_PERIOD_MS 200
+
+// bytes of conversions buffered by the driver between collects;
+// two collect periods (16000 bytes with the 2 byte ESP32 results)
+#define MS_ADC_POOL_SIZE (2 * MS_ADC_COLLECT_PERIOD_MS * MS_ADC_SAMPLE_FREQ_HZ / 1000 * SOC_ADC_DIGI_RESULT_BYTES)
+
+// longest wait of ms_adc_read for the first frame after ms_adc_start
+// (a frame is converted in ~6ms)
+#define MS_ADC_FIRST_SAMPLE_MS 20
+
+// samples kept per pin
+#define MS_ADC_RING_SIZE 256
+
+// default filter of every pin: trimmed mean of the last 64 samples
+// with the 16 lowest and 16 highest dropped
+#define MS_ADC_FILTER_MODE MS_FILTER_TRIMMED_MEAN
+#define MS_ADC_FILTER_SIZE 64
+#define MS_ADC_FILTER_TRIM 16
+
+bool ms_adc_init(const int *pins, int count);
+bool ms_adc_set_filter(int pin, int mode, int size, int trim);
+bool ms_adc_start();
+void ms_adc_stop();
+bool ms_adc_running();
+int ms_adc_collect();
+bool ms_adc_mean(int pin, int *target);
+bool ms_adc_filtered(int pin, int *target);
+bool ms_adc_latest(int pin, int *target);
+bool ms_adc_has_pin(int pin);
+bool ms_adc_read(int pin, int *target);
+bool ms_adc_to_mv(int pin, int raw, int *target);
+uint32_t ms_adc_overflows();
+
+#endif
@@ -8,6 +8,7 @@
 
 #include "ms_bluetooth.h"
 #include "utils/ms_central_utils/esp_central.h"
+#include "modules/ms_scheduler/ms_scheduler.h"
 #include "mothership_main.h"
 
 extern "C" void ble_store_config_init(void);
@@ -18,6 +19,41 @@ static void ms_bluetooth_scan(void);
 #define GATT_SVR_SVC_ENV_SENS_CHR_HUMIDITY_UUID 0x2A6F
 
 static BLEState *context = NULL;
+static Action *bleAction = NULL;
+static void (*hostEventqPut)(struct ble_npl_eventq *evq, struct ble_npl_event *ev) = NULL;
+
+/* Posts to the host queue and makes the next tick of the action due. */
+static void ms_bluetooth_eventq_put(struct ble_npl_eventq *evq, struct ble_npl_event *ev)
+{
+    hostEventqPut(evq, ev);
+
+    if (xPortInIsrContext())
+    {
+        ms_sched_tick_now_from_isr(bleAction);
+    }
+    else
+    {
+        ms_sched_tick_now(bleAction);
+    }
+}
+
+/* Routes every event posted to the host queue through
+ * ms_bluetooth_eventq_put; false if the queue cannot be hooked. */
+static bool ms_bluetooth_hook_eventq(void)
+{
+    npl_funcs_t *nplFuncs = npl_freertos_funcs_get();
+    if (nplFuncs == NULL || nplFuncs->p_ble_npl_eventq_put == NULL)
+    {
+        return false;
+    }
+
+    if (nplFuncs->p_ble_npl_eventq_put != &ms_bluetooth_eventq_put)
+    {
+        hostEventqPut = nplFuncs->p_ble_npl_eventq_put;
+        nplFuncs->p_ble_npl_eventq_put = &ms_bluetooth_eventq_put;
+    }
+    return true;
+}
 
 static int blecent_should_connect(const struct ble_gap_disc_desc *disc)
 {
@@ -347,6 +383,17 @@ void ms_ble_start(Action *a)
         return;
     }
 
+    bleAction = a;
+    if (ms_bluetooth_hook_eventq())
+    {
+        ms_sched_set_tick_interval(a, MS_BLE_IDLE_TICK_US);
+    }
+    else
+    {
+        ESP_LOGW("mothership", "Unable to hook the host queue; polling it");
+        ms_sched_set_tick_interval(a, MS_BLE_POLL_TICK_US);
+    }
+
     ble_hs_cfg.reset_cb = ms_bluetooth_on_reset;
     ble_hs_cfg.sync_cb = ms_bluetooth_on_sync;
     ble_hs_cfg.store_status_cb = ble_store_util_status_rr;
@@ -378,8 +425,9 @@ void ms_ble_tick(Action *a)
     struct ble_npl_event *ev;
     npl_funcs_t *nplFuncs = npl_freertos_funcs_get();
 
-    ev = nplFuncs->p_ble_npl_eventq_get(eventQueue, portTICK_PERIOD_MS);
-    if (ev)
+    // run everything queued since the last tick without blocking;
+    // the next event posted wakes the loop for another tick
+    while ((ev = nplFuncs->p_ble_npl_eventq_get(eventQueue, 0)) != nullptr)
     {
         nplFuncs->p_ble_npl_event_run(ev);
         // ESP_LOGI("mothership", "ms_ble: executed event");
@@ -1,5 +1,12 @@
 #include "modules/actions/actions.h"
 
+// The action ticks as soon as the host queue gets an event (HCI events
+// and data from the controller, expired callouts) and at least every
+// MS_BLE_IDLE_TICK_US; every MS_BLE_POLL_TICK_US if the queue cannot be
+// hooked. It has to be populated with to = 0
+#define MS_BLE_IDLE_TICK_US 1000000
+#define MS_BLE_POLL_TICK_US 10000
+
 void ms_ble_start(Action *a);
 void ms_ble_tick(Action *a);
 void ms_ble_stop(Action *a);
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include <math.h>
+#include <string.h>
+#include "ms_calibration.h"
+
+void ms_calibration_reset(MSCalibration *c)
+{
+	memset(c, 0, sizeof(MSCalibration));
+}
+
+void ms_calibration_push(MSCalibration *c, int value)
+{
+	if ((*c).count == 0 || value < (*c).min)
+	{
+		(*c).min = value;
+	}
+	if ((*c).count == 0 || value > (*c).max)
+	{
+		(*c).max = value;
+	}
+
+	(*c).count++;
+	(*c).sum += value;
+	(*c).squares += (int64_t)value * value;
+}
+
+// Mean of the readings rounded to the nearest count; 0 if there are none
+int ms_calibration_mean(const MSCalibration *c)
+{
+	if ((*c).count == 0)
+	{
+		return 0;
+	}
+
+	int64_t n = (*c).count;
+	return (int)(((*c).sum * 2 + n) / (n * 2));
+}
+
+// Standard deviation of the readings in counts
+int ms_calibration_spread(const MSCalibration *c)
+{
+	int64_t n = (*c).count;
+	if (n < 2)
+	{
+		return 0;
+	}
+
+	// n^2 * variance, kept in integers until the root
+	int64_t spread = n * (*c).squares - (*c).sum * (*c).sum;
+	return (int)(sqrt((double)spread / (double)(n * n)) + 0.5);
+}
+
+// Whether there are at least minCount readings and the standard
+// error of their mean is within error counts
+bool ms_calibration_stable(const MSCalibration *c, uint32_t minCount, int error)
+{
+	int64_t n = (*c).count;
+	if (n < 2 || (*c).count < minCount)
+	{
+		return false;
+	}
+
+	// variance / n <= error^2, both sides multiplied by n^3
+	double spread = (double)(n * (*c).squares - (*c).sum * (*c).sum);
+	return spread <= (double)error * error * (double)n * n * n;
+}
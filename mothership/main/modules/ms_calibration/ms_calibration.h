@@ -0,0 +1,37 @@
+#ifndef _MS_CALIBRATION_h
+#define _MS_CALIBRATION_h
+#include <stdint.h>
+
+// Streaming accumulator of the readings of a calibration point.
+//
+// Every reading taken while a sensor sits in completely dry (or wet)
+// soil is pushed into running integer sums, so the calibration value
+// is the mean of all of them instead of the last median, and its
+// spread (standard deviation) and sample count tell how reliable it
+// is. Pushing is O(1) and the accumulator never blocks; readings are
+// taken in batches by the caller, one batch per action tick.
+//
+// A point is stable once the standard error of its mean (spread over
+// the root of the count) is within a given number of counts, so noisy
+// sensors are read for longer and quiet ones are done early.
+
+// readings taken per tick of the calibration action (no delay
+// between them; ~1ms of oneshot conversions)
+#define MS_CALIBRATION_BATCH 16
+
+struct MSCalibration
+{
+	uint32_t count; // readings pushed
+	int64_t sum;
+	int64_t squares;
+	int min;
+	int max;
+};
+
+void ms_calibration_reset(MSCalibration *c);
+void ms_calibration_push(MSCalibration *c, int value);
+int ms_calibration_mean(const MSCalibration *c);
+int ms_calibration_spread(const MSCalibration *c);
+bool ms_calibration_stable(const MSCalibration *c, uint32_t minCount, int error);
+
+#endif
@@ -0,0 +1,70 @@
+#include <string.h>
+#include "ms_display.h"
+
+// Collects the changed column spans of every page of frame into spans
+// and copies them into flushed, which then equals frame. Returns the
+// number of spans, or -1 if there are more than maxSpans (flushed is
+// then a full copy of frame and the whole frame has to be sent).
+int ms_display_diff(const uint8_t *frame, uint8_t *flushed, int width, int pages, MSDisplaySpan *spans, int maxSpans)
+{
+	int count = 0;
+
+	for (int page = 0; page < pages; page++)
+	{
+		const uint8_t *row = &frame[page * width];
+		uint8_t *old = &flushed[page * width];
+		if (memcmp(row, old, width) == 0)
+		{
+			continue;
+		}
+
+		int start = -1;
+		int end = -1;
+		for (int x = 0; x < width; x++)
+		{
+			if (row[x] == old[x])
+			{
+				continue;
+			}
+
+			// a new span unless the gap to the open one costs less to resend
+			if (start != -1 && x - end - 1 > MS_DISPLAY_SPAN_OVERHEAD)
+			{
+				if (count == maxSpans)
+				{
+					memcpy(flushed, frame, width * pages);
+					return -1;
+				}
+				spans[count++] = {(uint8_t)page, (uint8_t)start, (uint8_t)end};
+				start = -1;
+			}
+
+			if (start == -1)
+			{
+				start = x;
+			}
+			end = x;
+		}
+
+		if (count == maxSpans)
+		{
+			memcpy(flushed, frame, width * pages);
+			return -1;
+		}
+		spans[count++] = {(uint8_t)page, (uint8_t)start, (uint8_t)end};
+		memcpy(old, row, width);
+	}
+
+	return count;
+}
+
+// Bytes the spans cost on the bus, address windows included
+int ms_display_span_bytes(const MSDisplaySpan *spans, int count)
+{
+	int bytes = 0;
+	for (int i = 0; i < count; i++)
+	{
+		bytes += MS_DISPLAY_SPAN_OVERHEAD + spans[i].end - spans[i].start + 1;
+	}
+	return bytes;
+}
@@ -0,0 +1,36 @@
+#ifndef _MS_DISPLAY_h
+#define _MS_DISPLAY_h
+#include <stdint.h>
+
+// Changed regions of an SSD1306 frame.
+//
+// The SSD1306 buffer is organized in pages of 8 pixel rows; every
+// byte is a column of 8 pixels in a page. Instead of sending the whole
+// 1 KB buffer the frame is compared with a copy of the last flushed
+// one, and the changed bytes of every page are collected into column
+// spans. A span is sent by setting the controller's column and page
+// address window and writing its bytes.
+//
+// Setting the window costs MS_DISPLAY_SPAN_OVERHEAD bytes on the bus,
+// so changed runs of a page closer than that to each other are merged
+// into one span (the unchanged bytes between them are resent).
+//
+// The kernel works on plain buffers and keeps no state, so it runs
+// the same on the host.
+
+// bus bytes of the address window of a span: the address and control
+// bytes and the 6 command bytes, plus the address and control bytes
+// of the data transfer
+#define MS_DISPLAY_SPAN_OVERHEAD 10
+
+struct MSDisplaySpan
+{
+	uint8_t page;
+	uint8_t start; // first column
+	uint8_t end;   // last column (inclusive)
+};
+
+int ms_display_diff(const uint8_t *frame, uint8_t *flushed, int width, int pages, MSDisplaySpan *spans, int maxSpans);
+int ms_display_span_bytes(const MSDisplaySpan *spans, int count);
+
+#endif
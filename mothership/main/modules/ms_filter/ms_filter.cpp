@@ -0,0 +1,149 @@
+#include <string.h>
+#include "ms_filter.h"
+
+#define MS_FILTER_SORT2(a, b)  \
+	if ((a) > (b))             \
+	{                          \
+		uint16_t t = (a);      \
+		(a) = (b);             \
+		(b) = t;               \
+	}
+
+// position of the first sample in sorted which is >= value
+static int _lowerBound(const uint16_t *sorted, int count, uint16_t value)
+{
+	int lo = 0;
+	int hi = count;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) >> 1;
+		if (sorted[mid] < value)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+void ms_filter_init(MSFilter *f, int mode, int size, int trim)
+{
+	if (size < 1)
+	{
+		size = 1;
+	}
+	if (size > MS_FILTER_WINDOW_MAX)
+	{
+		size = MS_FILTER_WINDOW_MAX;
+	}
+	if (trim < 0 || trim * 2 >= size)
+	{
+		trim = (size - 1) / 2;
+	}
+
+	(*f).mode = mode;
+	(*f).size = size;
+	(*f).trim = trim;
+	ms_filter_reset(f);
+}
+
+void ms_filter_reset(MSFilter *f)
+{
+	(*f).count = 0;
+	(*f).head = 0;
+}
+
+void ms_filter_push(MSFilter *f, uint16_t value)
+{
+	int count = (*f).count;
+
+	if (count < (*f).size)
+	{
+		(*f).window[count] = value;
+		int p = _lowerBound((*f).sorted, count, value);
+		memmove(&(*f).sorted[p + 1], &(*f).sorted[p], (count - p) * sizeof(uint16_t));
+		(*f).sorted[p] = value;
+		(*f).count = count + 1;
+		return;
+	}
+
+	// the new sample takes the slot of the oldest one; only the samples
+	// between the two values move, which is a few for a slow signal
+	uint16_t oldest = (*f).window[(*f).head];
+	(*f).window[(*f).head] = value;
+	(*f).head = (*f).head + 1 == (*f).size ? 0 : (*f).head + 1;
+
+	uint16_t *sorted = (*f).sorted;
+	int p = _lowerBound(sorted, count, oldest);
+	if (value > oldest)
+	{
+		while (p + 1 < count && sorted[p + 1] < value)
+		{
+			sorted[p] = sorted[p + 1];
+			p++;
+		}
+	}
+	else
+	{
+		while (p > 0 && sorted[p - 1] > value)
+		{
+			sorted[p] = sorted[p - 1];
+			p--;
+		}
+	}
+	sorted[p] = value;
+}
+
+bool ms_filter_value(MSFilter *f, int *target)
+{
+	int count = (*f).count;
+	if (count == 0)
+	{
+		return false;
+	}
+
+	if ((*f).mode == MS_FILTER_MEDIAN)
+	{
+		// the mean of the middle two for even counts
+		(*target) = ((int)(*f).sorted[(count - 1) >> 1] + (int)(*f).sorted[count >> 1]) >> 1;
+		return true;
+	}
+
+	// fewer samples than the window - trim proportionally
+	int trim = (*f).trim * count / (*f).size;
+	uint32_t sum = 0;
+	for (int i = trim; i < count - trim; i++)
+	{
+		sum += (*f).sorted[i];
+	}
+	(*target) = (int)(sum / (count - 2 * trim));
+	return true;
+}
+
+// Median of exactly 9 values; reorders them
+int ms_filter_median9(uint16_t *v)
+{
+	MS_FILTER_SORT2(v[1], v[2]);
+	MS_FILTER_SORT2(v[4], v[5]);
+	MS_FILTER_SORT2(v[7], v[8]);
+	MS_FILTER_SORT2(v[0], v[1]);
+	MS_FILTER_SORT2(v[3], v[4]);
+	MS_FILTER_SORT2(v[6], v[7]);
+	MS_FILTER_SORT2(v[1], v[2]);
+	MS_FILTER_SORT2(v[4], v[5]);
+	MS_FILTER_SORT2(v[7], v[8]);
+	MS_FILTER_SORT2(v[0], v[3]);
+	MS_FILTER_SORT2(v[5], v[8]);
+	MS_FILTER_SORT2(v[4], v[7]);
+	MS_FILTER_SORT2(v[3], v[6]);
+	MS_FILTER_SORT2(v[1], v[4]);
+	MS_FILTER_SORT2(v[2], v[5]);
+	MS_FILTER_SORT2(v[4], v[7]);
+	MS_FILTER_SORT2(v[4], v[2]);
+	MS_FILTER_SORT2(v[6], v[4]);
+	MS_FILTER_SORT2(v[4], v[2]);
+	return v[4];
+}
@@ -0,0 +1,40 @@
+#ifndef _MS_FILTER_h
+#define _MS_FILTER_h
+#include <stdint.h>
+
+// Robust reduction of raw ADC samples.
+//
+// A streaming filter keeps the last `size` samples twice: in arrival
+// order (to know which one leaves the window) and sorted. A push finds
+// the leaving sample by binary search and slides the new one into its
+// place, moving only the samples between the two values, so it is
+// cheap enough to run for every DMA sample. The median or the trimmed
+// mean (the `trim` lowest and highest samples dropped) is then read
+// straight from the sorted window. Integer arithmetic only.
+//
+// ms_filter_median9 is a 19 compare-exchange sorting network for the
+// one-off blocking reads.
+
+#define MS_FILTER_MEDIAN 0
+#define MS_FILTER_TRIMMED_MEAN 1
+
+#define MS_FILTER_WINDOW_MAX 64
+
+struct MSFilter
+{
+	uint16_t window[MS_FILTER_WINDOW_MAX]; // samples in arrival order (ring)
+	uint16_t sorted[MS_FILTER_WINDOW_MAX]; // the same samples sorted ascending
+	int mode;
+	int size;  // window length
+	int trim;  // samples dropped at each end for the trimmed mean
+	int count; // samples in the window
+	int head;  // oldest sample once the window is full
+};
+
+void ms_filter_init(MSFilter *f, int mode, int size, int trim);
+void ms_filter_reset(MSFilter *f);
+void ms_filter_push(MSFilter *f, uint16_t value);
+bool ms_filter_value(MSFilter *f, int *target);
+int ms_filter_median9(uint16_t *values);
+
+#endif
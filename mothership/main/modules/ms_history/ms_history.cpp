@@ -0,0 +1,91 @@
+#include <string.h>
+#include "ms_history.h"
+
+#define MS_HISTORY_MASK (MS_HISTORY_SIZE - 1)
+
+// moves x = 0 to the new origin: x' = x - d
+static void _rebase(MSHistory *h, uint32_t origin)
+{
+	int64_t d = (int64_t)origin - (int64_t)(*h).origin;
+	int64_t n = (*h).count;
+
+	(*h).sxx += -2 * d * (*h).sx + n * d * d;
+	(*h).sxy -= d * (*h).sy;
+	(*h).sx -= n * d;
+	(*h).origin = origin;
+}
+
+static void _updateSlope(MSHistory *h)
+{
+	int64_t n = (*h).count;
+	int64_t denominator = n * (*h).sxx - (*h).sx * (*h).sx;
+	if (n < 2 || denominator == 0)
+	{
+		(*h).slope = 0;
+		return;
+	}
+
+	(*h).slope = (float)(n * (*h).sxy - (*h).sx * (*h).sy) * 3600.0f / (float)denominator;
+}
+
+void ms_history_reset(MSHistory *h)
+{
+	memset(h, 0, sizeof(MSHistory));
+}
+
+void ms_history_push(MSHistory *h, uint32_t t, int raw, int p)
+{
+	if ((*h).count == 0)
+	{
+		(*h).origin = t;
+		(*h).ema = (float)p;
+	}
+	else
+	{
+		(*h).ema += MS_HISTORY_EMA_ALPHA * ((float)p - (*h).ema);
+	}
+
+	if ((*h).count == MS_HISTORY_SIZE)
+	{
+		// the oldest sample leaves the ring
+		MSHistorySample *oldest = &(*h).samples[(*h).head];
+		int64_t x = (int64_t)(*oldest).t - (*h).origin;
+		(*h).sx -= x;
+		(*h).sy -= (*oldest).p;
+		(*h).sxx -= x * x;
+		(*h).sxy -= x * (*oldest).p;
+		(*h).count--;
+	}
+
+	MSHistorySample *sample = &(*h).samples[(*h).head];
+	(*sample).t = t;
+	(*sample).raw = (uint16_t)raw;
+	(*sample).p = (int16_t)p;
+	(*h).head = ((*h).head + 1) & MS_HISTORY_MASK;
+
+	int64_t x = (int64_t)t - (*h).origin;
+	(*h).sx += x;
+	(*h).sy += p;
+	(*h).sxx += x * x;
+	(*h).sxy += x * p;
+	(*h).count++;
+
+	// keep x small: the origin follows the oldest sample
+	_rebase(h, (*ms_history_at(h, (*h).count - 1)).t);
+	_updateSlope(h);
+}
+
+const MSHistorySample *ms_history_latest(const MSHistory *h)
+{
+	return ms_history_at(h, 0);
+}
+
+// age 0 is the latest sample
+const MSHistorySample *ms_history_at(const MSHistory *h, int age)
+{
+	if (age < 0 || age >= (*h).count)
+	{
+		return nullptr;
+	}
+	return &(*h).samples[((*h).head - 1 - age) & MS_HISTORY_MASK];
+}
@@ -0,0 +1,56 @@
+#ifndef _MS_HISTORY_h
+#define _MS_HISTORY_h
+#include <stdint.h>
+
+// Reading history of a single sensor.
+//
+// The last MS_HISTORY_SIZE readings (time, raw value, percentage) are
+// kept in a ring of 8 byte samples. Every push also updates the
+// aggregates the rest of the application reads instead of the single
+// latest reading:
+//  - ema: exponential moving average of the percentage
+//  - slope: least squares slope of the percentage over the ring in
+//    percent per hour (negative while the soil is drying)
+//
+// The slope is kept as running integer sums over the ring (x is
+// seconds relative to the oldest sample), so a push is O(1) and the
+// sums never drift: the sample leaving the ring is subtracted exactly
+// and moving the origin to the new oldest sample is a closed form
+// shift of the sums.
+
+// samples kept per sensor (power of two)
+#define MS_HISTORY_SIZE 64
+
+// weight of the newest percentage in the moving average
+#define MS_HISTORY_EMA_ALPHA 0.25f
+
+struct MSHistorySample
+{
+	uint32_t t; // seconds since boot
+	uint16_t raw;
+	int16_t p; // percentage
+};
+
+struct MSHistory
+{
+	MSHistorySample samples[MS_HISTORY_SIZE];
+	int head;  // next write position
+	int count; // samples in the ring
+
+	// sums over the ring, x relative to origin
+	uint32_t origin;
+	int64_t sx;
+	int64_t sy;
+	int64_t sxx;
+	int64_t sxy;
+
+	float ema;	 // moving average of the percentage
+	float slope; // percent per hour
+};
+
+void ms_history_reset(MSHistory *h);
+void ms_history_push(MSHistory *h, uint32_t t, int raw, int p);
+const MSHistorySample *ms_history_latest(const MSHistory *h);
+const MSHistorySample *ms_history_at(const MSHistory *h, int age);
+
+#endif
@@ -0,0 +1,37 @@
+#include "ms_interpret.h"
+
+uint32_t ms_interpret_scale(int dry, int wet)
+{
+	int span = dry - wet;
+	if (span <= 0)
+	{
+		return MS_INTERPRET_NO_SCALE;
+	}
+
+	// rounded up so readings landing on a whole percent are not
+	// truncated to the one below
+	return (uint32_t)((((uint64_t)100 << MS_INTERPRET_SHIFT) + span - 1) / span);
+}
+
+void ms_interpret_scales(const int *dry, const int *wet, uint32_t *scale, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		scale[i] = ms_interpret_scale(dry[i], wet[i]);
+	}
+}
+
+// uncalibrated sensors need no branch: their scale zeroes the product
+int ms_interpret_percent(int value, int dry, int wet, uint32_t scale)
+{
+	int clamped = value < wet ? wet : (value > dry ? dry : value);
+	return (int)(((uint64_t)(uint32_t)(dry - clamped) * scale) >> MS_INTERPRET_SHIFT);
+}
+
+void ms_interpret_percents(const int *value, const int *dry, const int *wet, const uint32_t *scale, int *p, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		p[i] = ms_interpret_percent(value[i], dry[i], wet[i], scale[i]);
+	}
+}
@@ -0,0 +1,31 @@
+#ifndef _MS_INTERPRET_h
+#define _MS_INTERPRET_h
+#include <stdint.h>
+
+// Raw sensor reading -> humidity percentage.
+//
+// A sensor calibrated to dry and wet reads dry in completely dry and
+// wet in completely wet soil (dry > wet). The percentage of a reading
+// is 100 * (dry - v) / (dry - wet) with v clamped to [wet, dry].
+//
+// The division is replaced by a per sensor scale factor derived with
+// ms_interpret_scale whenever dry/wet change: 100 / (dry - wet) as a
+// Q24 fixed point number rounded up. A reading then costs a multiply
+// and a shift, and for 12 bit readings the result equals the integer
+// division exactly (the rounding error of the scale stays below the
+// smallest fraction of a percent a reading can land on).
+//
+// The kernels work on plain arrays (one entry per sensor) and keep
+// no state, so they run the same on the host.
+
+#define MS_INTERPRET_SHIFT 24
+
+// scale of an uncalibrated sensor (dry <= wet); always reads 0%
+#define MS_INTERPRET_NO_SCALE 0
+
+uint32_t ms_interpret_scale(int dry, int wet);
+void ms_interpret_scales(const int *dry, const int *wet, uint32_t *scale, int count);
+int ms_interpret_percent(int value, int dry, int wet, uint32_t scale);
+void ms_interpret_percents(const int *value, const int *dry, const int *wet, const uint32_t *scale, int *p, int count);
+
+#endif
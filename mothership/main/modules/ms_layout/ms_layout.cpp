@@ -0,0 +1,64 @@
+#include <string.h>
+#include "ms_layout.h"
+
+// FNV-1a of the text and the size; length is set to the
+// text length, or -1 if the text is too long to be cached
+static uint32_t _hash(const char *text, int size, int *length)
+{
+	uint32_t hash = 2166136261u;
+	int i = 0;
+	for (; text[i] != '\0'; i++)
+	{
+		if (i == MS_LAYOUT_MAX_TEXT)
+		{
+			(*length) = -1;
+			return 0;
+		}
+		hash = (hash ^ (uint8_t)text[i]) * 16777619u;
+	}
+	(*length) = i;
+	return (hash ^ (uint8_t)size) * 16777619u;
+}
+
+void ms_layout_reset(MSLayoutCache *c)
+{
+	memset(c, 0, sizeof(MSLayoutCache));
+}
+
+// Whether the bounds of text at size are cached; they are set to w and h
+bool ms_layout_find(MSLayoutCache *c, const char *text, int size, uint16_t *w, uint16_t *h)
+{
+	int length;
+	uint32_t hash = _hash(text, size, &length);
+	if (length != -1)
+	{
+		MSLayoutEntry *e = &(*c).entries[hash & (MS_LAYOUT_CACHE_SIZE - 1)];
+		if ((*e).size == size && (*e).hash == hash && memcmp((*e).text, text, length + 1) == 0)
+		{
+			(*c).hits++;
+			(*w) = (*e).w;
+			(*h) = (*e).h;
+			return true;
+		}
+	}
+
+	(*c).misses++;
+	return false;
+}
+
+void ms_layout_store(MSLayoutCache *c, const char *text, int size, uint16_t w, uint16_t h)
+{
+	int length;
+	uint32_t hash = _hash(text, size, &length);
+	if (length == -1 || size <= 0)
+	{
+		return;
+	}
+
+	MSLayoutEntry *e = &(*c).entries[hash & (MS_LAYOUT_CACHE_SIZE - 1)];
+	(*e).hash = hash;
+	(*e).size = (uint8_t)size;
+	(*e).w = w;
+	(*e).h = h;
+	memcpy((*e).text, text, length + 1);
+}
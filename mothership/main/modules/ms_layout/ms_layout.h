@@ -0,0 +1,46 @@
+#ifndef _MS_LAYOUT_h
+#define _MS_LAYOUT_h
+#include <stdint.h>
+
+// Cache of text bounds for laying out the screens.
+//
+// Measuring a string (getTextBounds) walks the glyphs of every
+// character, and the screens measure the same menu entries, prompts
+// and captions on every frame. The cache maps the contents of a
+// string and its text size to the measured width and height.
+//
+// It is keyed by contents rather than by pointer: the same pooled
+// buffers hold different texts from frame to frame, while a constant
+// shows up at several addresses. Entries are direct mapped on a hash
+// of the contents and the size and keep a copy of the text, so a hit
+// is always exact; a miss replaces whatever was in the slot. Texts
+// longer than MS_LAYOUT_MAX_TEXT are never cached.
+//
+// The bounds only hold for one font; the cache is meant for a
+// single font and has to be reset if it changes.
+
+// entries, a power of 2
+#define MS_LAYOUT_CACHE_SIZE 64
+#define MS_LAYOUT_MAX_TEXT 31
+
+struct MSLayoutEntry
+{
+	uint32_t hash;
+	uint8_t size; // text size, 0 - empty entry
+	uint16_t w;
+	uint16_t h;
+	char text[MS_LAYOUT_MAX_TEXT + 1];
+};
+
+struct MSLayoutCache
+{
+	MSLayoutEntry entries[MS_LAYOUT_CACHE_SIZE];
+	uint32_t hits;
+	uint32_t misses;
+};
+
+void ms_layout_reset(MSLayoutCache *c);
+bool ms_layout_find(MSLayoutCache *c, const char *text, int size, uint16_t *w, uint16_t *h);
+void ms_layout_store(MSLayoutCache *c, const char *text, int size, uint16_t w, uint16_t h);
+
+#endif
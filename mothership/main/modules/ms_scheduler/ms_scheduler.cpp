@@ -0,0 +1,1512 @@
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "ms_scheduler.h"
+
+#define MS_SCHED_FLAG_TOUCHED 1	  // needs its deadline recalculated
+#define MS_SCHED_FLAG_DUE 2		  // was due in the current pass
+#define MS_SCHED_FLAG_FIRED 4	  // one of its callbacks ran in the current pass
+#define MS_SCHED_FLAG_REQUESTED 8 // scheduled/stopped through the API
+#define MS_SCHED_FLAG_QUEUED 16	  // scheduled and not stopped through the API
+#define MS_SCHED_FLAG_BLOCKED 32  // was due, but did not start
+#define MS_SCHED_FLAG_TRIGGERED 64 // waiting to run in the current cycle
+#define MS_SCHED_FLAG_WOKEN 128	   // its next tick is due right away
+
+#ifndef _max
+#define _max(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+#define MS_SCHED_REQUEST_SCHEDULE 0
+#define MS_SCHED_REQUEST_STOP 1
+#define MS_SCHED_REQUEST_TOUCH 2
+#define MS_SCHED_REQUEST_TRIGGER 3
+#define MS_SCHED_REQUEST_END 4
+#define MS_SCHED_REQUEST_TICK 5
+
+typedef void (*MSActionCallback)(Action *a);
+typedef bool (*MSCanStartCallback)(Action *a);
+
+// upper bounds (exclusive) of the histogram buckets in us;
+// the last bucket collects everything above
+static const uint32_t _bucketBounds[MS_SCHED_HISTOGRAM_BUCKETS - 1] = {100, 250, 1000, 2500, 10000, 25000, 100000};
+
+static ActionsList *_list = nullptr;
+static int _count = 0;
+
+// min-heap of action indices ordered by _deadline
+static int *_heap = nullptr;
+static int _heapSize = 0;
+// position of each action in _heap; -1 when not in the heap
+static int *_pos = nullptr;
+static MSSchedTime *_deadline = nullptr;
+static MSSchedTime *_lastTick = nullptr;
+// tick interval in us overriding to; 0 - use to
+static uint32_t *_tickInterval = nullptr;
+static unsigned char *_flags = nullptr;
+
+// actions whose deadline has to be recalculated
+static int *_touched = nullptr;
+static int _touchedCount = 0;
+
+// the task running the loop; woken by ms_sched_wake
+static TaskHandle_t _loopTask = nullptr;
+
+static bool _inPass = false;
+static bool _stopSeen = false;
+static MSSchedTime _passTime = 0;
+
+// incremented on every ms_sched_run which does any work
+static unsigned long _cycle = 0;
+// cycle in which the action was last ticked
+static unsigned long *_tickedIn = nullptr;
+// set when an action is scheduled; a follow up pass lets it start in the same cycle
+static bool _rescheduled = false;
+
+// actions triggered in the current cycle and their payloads
+static int *_triggered = nullptr;
+static int _triggeredCount = 0;
+static int *_hop = nullptr;
+static void **_payload = nullptr;
+// triggered actions left to a run of the library (see _runTriggered),
+// whether that run ticked, and whether it was scheduled for them only
+static bool *_handedOver = nullptr;
+static bool *_ticked = nullptr;
+static bool *_oneShot = nullptr;
+
+// the callbacks as populated by the application
+static MSActionCallback *_starts = nullptr;
+static MSActionCallback *_ticks = nullptr;
+static MSActionCallback *_stops = nullptr;
+static MSCanStartCallback *_canStarts = nullptr;
+
+// actions which keep each action from starting while they run
+static uint64_t *_blockers = nullptr;
+// actions between their start and stop, one bit per action
+static volatile uint64_t _running = 0;
+
+static MSSchedStats *_stats = nullptr;
+
+static unsigned char *_priority = nullptr;
+// next start/stop of the critical actions
+static MSSchedTime *_transition = nullptr;
+static bool *_hasTransition = nullptr;
+// earliest of the critical transitions; recalculated when one changes
+static MSSchedTime _criticalTransition = 0;
+static bool _hasCriticalTransition = false;
+static bool _transitionsChanged = false;
+// when ms_sched_stop was called; 0 - not requested
+static int64_t *_stopRequestedAt = nullptr;
+// runs cut short by ms_sched_end: the duration
+// populated by the application and the one cut to
+static bool *_ended = nullptr;
+static unsigned long *_endedTd = nullptr;
+static unsigned long *_cutTd = nullptr;
+
+// core of the worker running the ticks of each action
+static int *_worker = nullptr;
+// set while a worker is running a tick of the action
+static volatile bool *_busy = nullptr;
+// stops held back until the worker is done with the tick; set under _mux
+static volatile bool *_stopHeld = nullptr;
+static int _heldStops = 0;
+// called on the loop task right before each tick of the action
+static MSActionCallback *_snapshots = nullptr;
+static QueueHandle_t _workerQueues[portNUM_PROCESSORS];
+
+struct MSSchedCall
+{
+	int index;
+	int phase;
+};
+
+// callbacks of the non critical actions held back until the end of the walk
+static MSSchedCall *_deferred = nullptr;
+static int _deferredCount = 0;
+
+struct MSSchedRequest
+{
+	int index;
+	int type;
+	void *payload;
+};
+
+// requests made from tasks other than the loop task
+static MSSchedRequest _requests[MS_SCHED_REQUESTS_SIZE];
+static int _requestsCount = 0;
+
+// consecutive ticks over budget
+static unsigned char *_overrunStreak = nullptr;
+// duration of the tick which completed the streak
+static uint32_t *_overrunDuration = nullptr;
+// actions waiting to be demoted by the loop task
+static volatile bool *_demoteRequested = nullptr;
+// actions whose ticks may be moved to a worker when demoted
+static bool *_offloadable = nullptr;
+static volatile bool _demotePending = false;
+
+// guards _requests and the statistics updated from the workers
+static portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Time helpers
+//
+// The scheduler works on the 64 bit microsecond clock; the Action
+// fields and doQueueActions keep the millisecond values of the Actions
+// library, which wrap after ~49 days. Millisecond stamps are unwrapped
+// relative to the current time before they are compared.
+
+static bool _after(MSSchedTime a, MSSchedTime b)
+{
+	return a > b;
+}
+
+// The millisecond clock of the library. Its stamps are 32 bit (unsigned
+// long on the ESP32) and wrap every 49.7 days; they are cut to 32 bits
+// on the host as well, so the host tests see the same wrap
+static unsigned long _toMs(MSSchedTime t)
+{
+	return (unsigned long)(uint32_t)(t / 1000);
+}
+
+// milliseconds from stamp to now on the 32 bit clock
+static uint32_t _msSince(unsigned long ms, MSSchedTime now)
+{
+	return (uint32_t)_toMs(now) - (uint32_t)ms;
+}
+
+// the 64 bit time of a millisecond stamp taken at or before now
+static MSSchedTime _fromMs(unsigned long ms, MSSchedTime now)
+{
+	return (now / 1000 - _msSince(ms, now)) * 1000;
+}
+
+static MSSchedTime _us(unsigned long ms)
+{
+	return (MSSchedTime)ms * 1000;
+}
+
+static bool _isRunning(int state)
+{
+	return state == MS_RUNNING || state == MS_CHILD_RUNNING;
+}
+
+static int _indexOf(Action *a)
+{
+	int i = (int)(a - (*_list).availableActions);
+	return (i >= 0 && i < _count) ? i : -1;
+}
+
+// Heap
+
+static void _heapSwap(int p1, int p2)
+{
+	int i1 = _heap[p1];
+	int i2 = _heap[p2];
+	_heap[p1] = i2;
+	_heap[p2] = i1;
+	_pos[i2] = p1;
+	_pos[i1] = p2;
+}
+
+static void _heapUp(int p)
+{
+	while (p > 0)
+	{
+		int parent = (p - 1) / 2;
+		if (!_after(_deadline[_heap[parent]], _deadline[_heap[p]]))
+		{
+			break;
+		}
+		_heapSwap(p, parent);
+		p = parent;
+	}
+}
+
+static void _heapDown(int p)
+{
+	while (true)
+	{
+		int l = 2 * p + 1;
+		int r = l + 1;
+		int m = p;
+		if (l < _heapSize && _after(_deadline[_heap[m]], _deadline[_heap[l]]))
+		{
+			m = l;
+		}
+		if (r < _heapSize && _after(_deadline[_heap[m]], _deadline[_heap[r]]))
+		{
+			m = r;
+		}
+		if (m == p)
+		{
+			break;
+		}
+		_heapSwap(p, m);
+		p = m;
+	}
+}
+
+static void _heapSet(int i, MSSchedTime deadline)
+{
+	_deadline[i] = deadline;
+	if (_pos[i] < 0)
+	{
+		_pos[i] = _heapSize;
+		_heap[_heapSize++] = i;
+	}
+	_heapUp(_pos[i]);
+	_heapDown(_pos[i]);
+}
+
+static void _heapRemove(int i)
+{
+	int p = _pos[i];
+	if (p < 0)
+	{
+		return;
+	}
+
+	int last = --_heapSize;
+	if (p != last)
+	{
+		_heapSwap(p, last);
+	}
+	_pos[i] = -1;
+
+	if (p < _heapSize)
+	{
+		_heapUp(p);
+		_heapDown(p);
+	}
+}
+
+// Deadlines
+
+static void _touch(int i, unsigned char flags)
+{
+	if ((_flags[i] & MS_SCHED_FLAG_TOUCHED) == 0)
+	{
+		_touched[_touchedCount++] = i;
+	}
+	_flags[i] |= MS_SCHED_FLAG_TOUCHED | flags;
+}
+
+static MSSchedTime _calculateDeadline(int i, MSSchedTime now)
+{
+	Action *a = &(*_list).availableActions[i];
+	MSSchedTime d;
+
+	if (_isRunning((*a).state))
+	{
+		// next tick; a tick interval of 0 means every pass
+		if ((_flags[i] & MS_SCHED_FLAG_WOKEN) != 0)
+		{
+			d = now;
+		}
+		else if (_tickInterval[i] > 0)
+		{
+			d = _lastTick[i] + _tickInterval[i];
+		}
+		else
+		{
+			d = (*a).to > 0 ? _lastTick[i] + _us((*a).to) : now;
+		}
+
+		// a duration of 0 means we never stop
+		MSSchedTime stopAt = _fromMs((*a).st, now) + _us((*a).td);
+		if ((*a).td > 0 && _after(d, stopAt))
+		{
+			d = stopAt;
+		}
+	}
+	else
+	{
+		// next start
+		d = (*a).lst > 0 ? _fromMs((*a).lst, now) + _us((*a).ti) : now;
+	}
+
+	if (_after(d, now + _us(MS_SCHED_MAX_IDLE_MS)))
+	{
+		d = now + _us(MS_SCHED_MAX_IDLE_MS);
+	}
+
+	return d;
+}
+
+static void _updateTransition(int i, MSSchedTime now, MSSchedTime deadline, bool requested)
+{
+	Action *a = &(*_list).availableActions[i];
+	if (_priority[i] == MS_SCHED_PRIORITY_CRITICAL)
+	{
+		_transitionsChanged = true;
+	}
+
+	if (requested)
+	{
+		// stop requests for actions which are not running are no-ops
+		_hasTransition[i] = _isRunning((*a).state) || (_flags[i] & MS_SCHED_FLAG_QUEUED) != 0;
+		_transition[i] = now;
+	}
+	else if (_isRunning((*a).state))
+	{
+		_hasTransition[i] = (*a).td > 0;
+		_transition[i] = _fromMs((*a).st, now) + _us((*a).td);
+	}
+	else
+	{
+		_hasTransition[i] = (_flags[i] & MS_SCHED_FLAG_BLOCKED) == 0;
+		_transition[i] = deadline;
+	}
+}
+
+static void _update(int i, MSSchedTime now)
+{
+	Action *a = &(*_list).availableActions[i];
+	unsigned char f = _flags[i];
+	_flags[i] &= ~(MS_SCHED_FLAG_TOUCHED | MS_SCHED_FLAG_DUE | MS_SCHED_FLAG_FIRED | MS_SCHED_FLAG_REQUESTED | MS_SCHED_FLAG_BLOCKED);
+
+	// the library picks up schedule/stop requests on its next pass
+	if ((f & MS_SCHED_FLAG_REQUESTED) != 0)
+	{
+		_updateTransition(i, now, now, true);
+		_heapSet(i, now);
+		return;
+	}
+
+	// not frozen actions are removed from the list once they stop
+	if ((*a).state == MS_NON_ACTIVE && !((*a).frozen && (f & MS_SCHED_FLAG_QUEUED) != 0))
+	{
+		_hasTransition[i] = false;
+		_transitionsChanged = true;
+		_heapRemove(i);
+		return;
+	}
+
+	if (!_isRunning((*a).state))
+	{
+		_stopRequestedAt[i] = 0;
+	}
+
+	MSSchedTime d = _calculateDeadline(i, now);
+
+	// canStart refused to let the action start - poll it slowly
+	// (or right after something stops) instead of on every pass
+	if ((f & MS_SCHED_FLAG_DUE) != 0 && (f & MS_SCHED_FLAG_FIRED) == 0 && !_isRunning((*a).state) && !_after(d, now))
+	{
+		d = now + _us(MS_SCHED_BLOCKED_POLL_MS);
+		_flags[i] |= MS_SCHED_FLAG_BLOCKED;
+	}
+
+	_updateTransition(i, now, d, false);
+	_heapSet(i, d);
+}
+
+// true when a critical action has to start or stop before limit;
+// the earliest transition is only searched for again after one of
+// them changed, so best effort ticks don't walk all actions
+static bool _criticalTransitionBefore(MSSchedTime limit)
+{
+	if (_transitionsChanged)
+	{
+		_transitionsChanged = false;
+		_hasCriticalTransition = false;
+		for (int i = 0; i < _count; i++)
+		{
+			if (_priority[i] != MS_SCHED_PRIORITY_CRITICAL || !_hasTransition[i])
+			{
+				continue;
+			}
+
+			if (!_hasCriticalTransition || _after(_criticalTransition, _transition[i]))
+			{
+				_criticalTransition = _transition[i];
+				_hasCriticalTransition = true;
+			}
+		}
+	}
+
+	return _hasCriticalTransition && !_after(_criticalTransition, limit);
+}
+
+static void _flushTouched(MSSchedTime now)
+{
+	for (int t = 0; t < _touchedCount; t++)
+	{
+		_update(_touched[t], now);
+	}
+	_touchedCount = 0;
+}
+
+static void _releaseBlocked(MSSchedTime now)
+{
+	for (int p = 0; p < _heapSize; p++)
+	{
+		int i = _heap[p];
+		if ((_flags[i] & MS_SCHED_FLAG_BLOCKED) != 0)
+		{
+			_touch(i, MS_SCHED_FLAG_REQUESTED);
+		}
+	}
+	_flushTouched(now);
+}
+
+// Timing
+
+static void _record(int i, int phase, int64_t startedAt)
+{
+	uint32_t us = (uint32_t)(esp_timer_get_time() - startedAt);
+	MSSchedStats *s = &_stats[i];
+	MSSchedTiming *t = &(*s).phases[phase];
+
+	int b = 0;
+	while (b < MS_SCHED_HISTOGRAM_BUCKETS - 1 && us >= _bucketBounds[b])
+	{
+		b++;
+	}
+
+	portENTER_CRITICAL(&_mux);
+	(*t).hist[b]++;
+	(*t).count++;
+	(*t).total += us;
+	if (us > (*t).max)
+	{
+		(*t).max = us;
+	}
+
+	if ((*s).budget > 0 && us > (*s).budget)
+	{
+		(*s).overruns++;
+
+		// critical actions keep running however long they take
+		if (phase == MS_SCHED_PHASE_TICK && _priority[i] != MS_SCHED_PRIORITY_CRITICAL && ++_overrunStreak[i] >= MS_SCHED_DEMOTE_OVERRUNS)
+		{
+			_overrunStreak[i] = 0;
+			_overrunDuration[i] = us;
+			_demoteRequested[i] = true;
+			_demotePending = true;
+		}
+	}
+	else if (phase == MS_SCHED_PHASE_TICK)
+	{
+		_overrunStreak[i] = 0;
+	}
+	portEXIT_CRITICAL(&_mux);
+}
+
+// Conflicts
+
+static void _setRunning(int i, bool running)
+{
+	if (i >= MS_SCHED_MAX_CONFLICT_ACTIONS)
+	{
+		return;
+	}
+
+	if (running)
+	{
+		_running |= MS_SCHED_BIT(i);
+	}
+	else
+	{
+		_running &= ~MS_SCHED_BIT(i);
+	}
+}
+
+// Callback trampolines
+
+static void _call(int i, int phase, MSActionCallback callback, Action *a)
+{
+	if (callback == nullptr)
+	{
+		return;
+	}
+
+	int64_t t = esp_timer_get_time();
+	callback(a);
+	_record(i, phase, t);
+}
+
+static void _runTick(int i);
+static void _recordStopLatency(int i, int64_t stoppedAt);
+static void _trigger(int i, void *payload);
+static void _requestStop(int i);
+
+// After a run of a triggered action made by the library: a run which
+// ticked used the payload, which is dropped; one which did not passes
+// the trigger on to a run of its own
+static void _settleTrigger(int i)
+{
+	if (!_handedOver[i])
+	{
+		return;
+	}
+	_handedOver[i] = false;
+
+	if (!_ticked[i])
+	{
+		_trigger(i, _payload[i]);
+		return;
+	}
+
+	_payload[i] = nullptr;
+	if (_oneShot[i])
+	{
+		_oneShot[i] = false;
+		_requestStop(i);
+	}
+}
+
+static void _runStop(int i)
+{
+	_setRunning(i, false);
+	_recordStopLatency(i, esp_timer_get_time());
+	_call(i, MS_SCHED_PHASE_STOP, _stops[i], &(*_list).availableActions[i]);
+	_settleTrigger(i);
+}
+
+static void _run(int i, int phase)
+{
+	Action *a = &(*_list).availableActions[i];
+	switch (phase)
+	{
+	case MS_SCHED_PHASE_START:
+		_call(i, MS_SCHED_PHASE_START, _starts[i], a);
+		break;
+	case MS_SCHED_PHASE_TICK:
+		_runTick(i);
+		break;
+	case MS_SCHED_PHASE_STOP:
+	{
+		// never stop an action in the middle of a tick on another core;
+		// the worker wakes the loop task once the tick is done
+		portENTER_CRITICAL(&_mux);
+		bool busy = _busy[i];
+		_stopHeld[i] = busy;
+		portEXIT_CRITICAL(&_mux);
+
+		if (busy)
+		{
+			_heldStops++;
+		}
+		else
+		{
+			_runStop(i);
+		}
+	}
+	break;
+	}
+}
+
+// Runs the held stops of the actions whose worker tick is done
+static void _runHeldStops()
+{
+	if (_heldStops == 0)
+	{
+		return;
+	}
+
+	bool released = false;
+	for (int i = 0; i < _count; i++)
+	{
+		portENTER_CRITICAL(&_mux);
+		bool done = _stopHeld[i] && !_busy[i];
+		if (done)
+		{
+			_stopHeld[i] = false;
+		}
+		portEXIT_CRITICAL(&_mux);
+
+		if (done)
+		{
+			_heldStops--;
+			_runStop(i);
+			released = true;
+		}
+	}
+
+	// the actions kept from starting meanwhile get another chance
+	if (released)
+	{
+		for (int p = 0; p < _heapSize; p++)
+		{
+			if ((_flags[_heap[p]] & MS_SCHED_FLAG_BLOCKED) != 0)
+			{
+				_touch(_heap[p], MS_SCHED_FLAG_REQUESTED);
+			}
+		}
+	}
+}
+
+// Callbacks of critical actions run right away; the others wait for
+// the end of the library's walk, so no start, tick or stop of a lower
+// class runs before a transition of a higher one due in the same pass
+static void _dispatch(int i, int phase)
+{
+	if (!_inPass || _priority[i] == MS_SCHED_PRIORITY_CRITICAL)
+	{
+		_run(i, phase);
+		return;
+	}
+
+	_deferred[_deferredCount].index = i;
+	_deferred[_deferredCount].phase = phase;
+	_deferredCount++;
+}
+
+// Runs the held back callbacks, normal before best effort,
+// each class in the order the library made the calls
+static void _runDeferred()
+{
+	int count = _deferredCount;
+	_deferredCount = 0;
+
+	for (int p = MS_SCHED_PRIORITY_NORMAL; p <= MS_SCHED_PRIORITY_BEST_EFFORT; p++)
+	{
+		for (int d = 0; d < count; d++)
+		{
+			if (_priority[_deferred[d].index] == p)
+			{
+				_run(_deferred[d].index, _deferred[d].phase);
+			}
+		}
+	}
+}
+
+static void _start(Action *a)
+{
+	int i = _indexOf(a);
+	_touch(i, MS_SCHED_FLAG_FIRED);
+	_lastTick[i] = _passTime;
+	_setRunning(i, true);
+	_dispatch(i, MS_SCHED_PHASE_START);
+}
+
+static bool _canStart(Action *a)
+{
+	int i = _indexOf(a);
+	// the stop of the previous run has not run yet
+	if (_stopHeld[i] || (_blockers[i] & _running) != 0)
+	{
+		return false;
+	}
+
+	return _canStarts[i] == nullptr || _canStarts[i](a);
+}
+
+static void _tick(Action *a)
+{
+	int i = _indexOf(a);
+	_touch(i, MS_SCHED_FLAG_FIRED);
+
+	// the library offers a tick on every pass (to = 0);
+	// sub-millisecond intervals are kept here
+	if (_tickInterval[i] > 0 && (_flags[i] & MS_SCHED_FLAG_WOKEN) == 0 && _after(_lastTick[i] + _tickInterval[i], _passTime))
+	{
+		return;
+	}
+	_lastTick[i] = _passTime;
+	_flags[i] &= ~MS_SCHED_FLAG_WOKEN;
+
+	if (_ticks[i] == nullptr)
+	{
+		return;
+	}
+
+	// follow up passes must not tick the same action twice
+	if (_tickedIn[i] == _cycle)
+	{
+		return;
+	}
+	_tickedIn[i] = _cycle;
+
+	// let the valves and the pump go first
+	if (_priority[i] == MS_SCHED_PRIORITY_BEST_EFFORT && _criticalTransitionBefore(_passTime + _us(MS_SCHED_YIELD_WINDOW_MS)))
+	{
+		_stats[i].yields++;
+		return;
+	}
+
+	_ticked[i] = true;
+	_dispatch(i, MS_SCHED_PHASE_TICK);
+}
+
+static void _runTick(int i)
+{
+	Action *a = &(*_list).availableActions[i];
+	if (_worker[i] != MS_SCHED_WORKER_NONE)
+	{
+		// the previous tick is still running
+		if (_busy[i])
+		{
+			_stats[i].busy++;
+			return;
+		}
+
+		// the worker is idle, so the snapshot is not being read
+		if (_snapshots[i] != nullptr)
+		{
+			_snapshots[i](a);
+		}
+
+		_busy[i] = true;
+		if (xQueueSend(_workerQueues[_worker[i]], &i, 0) != pdTRUE)
+		{
+			_busy[i] = false;
+		}
+		return;
+	}
+
+	if (_snapshots[i] != nullptr)
+	{
+		_snapshots[i](a);
+	}
+
+	int64_t t = esp_timer_get_time();
+	_ticks[i](a);
+	_record(i, MS_SCHED_PHASE_TICK, t);
+}
+
+static void _runWorker(void *queue)
+{
+	int i;
+	while (true)
+	{
+		if (xQueueReceive((QueueHandle_t)queue, &i, portMAX_DELAY) == pdTRUE)
+		{
+			int64_t t = esp_timer_get_time();
+			_ticks[i](&(*_list).availableActions[i]);
+			_record(i, MS_SCHED_PHASE_TICK, t);
+
+			portENTER_CRITICAL(&_mux);
+			_busy[i] = false;
+			bool held = _stopHeld[i];
+			portEXIT_CRITICAL(&_mux);
+
+			// its stop waits for this tick
+			if (held)
+			{
+				ms_sched_wake();
+			}
+		}
+	}
+}
+
+static void _recordStopLatency(int i, int64_t stoppedAt)
+{
+	Action *a = &(*_list).availableActions[i];
+	int64_t dueAt;
+
+	if (_stopRequestedAt[i] != 0)
+	{
+		dueAt = _stopRequestedAt[i];
+	}
+	else if ((*a).td > 0)
+	{
+		// the duration expired
+		dueAt = _fromMs((*a).st, stoppedAt) + _us((*a).td);
+	}
+	else
+	{
+		// stopped together with its parent; nothing to measure
+		return;
+	}
+
+	_stopRequestedAt[i] = 0;
+
+	uint32_t latency = stoppedAt > dueAt ? (uint32_t)(stoppedAt - dueAt) : 0;
+	MSSchedStats *s = &_stats[i];
+	if (latency > (*s).stopMax)
+	{
+		(*s).stopMax = latency;
+	}
+	if (latency > MS_SCHED_STOP_LATENCY_BOUND_US)
+	{
+		(*s).stopLate++;
+		if (_priority[i] == MS_SCHED_PRIORITY_CRITICAL)
+		{
+			ESP_LOGW(MS_SCHED_TAG, "%s: stopped %u us late", (*a).name, (unsigned)latency);
+		}
+	}
+}
+
+static void _stop(Action *a)
+{
+	int i = _indexOf(a);
+	_touch(i, MS_SCHED_FLAG_FIRED);
+	_stopSeen = true;
+
+	// the next run gets the whole duration again, unless
+	// the application has set another one meanwhile
+	if (_ended[i])
+	{
+		_ended[i] = false;
+		if ((*a).td == _cutTd[i])
+		{
+			(*a).td = _endedTd[i];
+		}
+	}
+	_dispatch(i, MS_SCHED_PHASE_STOP);
+}
+
+// API
+
+void ms_sched_init(ActionsList *list)
+{
+	_list = list;
+	_count = (*list).availableActionsCount;
+	_loopTask = xTaskGetCurrentTaskHandle();
+
+	_heap = (int *)calloc(_count, sizeof(int));
+	_pos = (int *)calloc(_count, sizeof(int));
+	_touched = (int *)calloc(_count, sizeof(int));
+	_deadline = (MSSchedTime *)calloc(_count, sizeof(MSSchedTime));
+	_lastTick = (MSSchedTime *)calloc(_count, sizeof(MSSchedTime));
+	_tickInterval = (uint32_t *)calloc(_count, sizeof(uint32_t));
+	_overrunStreak = (unsigned char *)calloc(_count, sizeof(unsigned char));
+	_overrunDuration = (uint32_t *)calloc(_count, sizeof(uint32_t));
+	_demoteRequested = (volatile bool *)calloc(_count, sizeof(bool));
+	_offloadable = (bool *)calloc(_count, sizeof(bool));
+	_flags = (unsigned char *)calloc(_count, sizeof(unsigned char));
+	_starts = (MSActionCallback *)calloc(_count, sizeof(MSActionCallback));
+	_ticks = (MSActionCallback *)calloc(_count, sizeof(MSActionCallback));
+	_stops = (MSActionCallback *)calloc(_count, sizeof(MSActionCallback));
+	_stats = (MSSchedStats *)calloc(_count, sizeof(MSSchedStats));
+	_priority = (unsigned char *)calloc(_count, sizeof(unsigned char));
+	_transition = (MSSchedTime *)calloc(_count, sizeof(MSSchedTime));
+	_hasTransition = (bool *)calloc(_count, sizeof(bool));
+	_stopRequestedAt = (int64_t *)calloc(_count, sizeof(int64_t));
+	_ended = (bool *)calloc(_count, sizeof(bool));
+	_endedTd = (unsigned long *)calloc(_count, sizeof(unsigned long));
+	_cutTd = (unsigned long *)calloc(_count, sizeof(unsigned long));
+	_worker = (int *)calloc(_count, sizeof(int));
+	_busy = (volatile bool *)calloc(_count, sizeof(bool));
+	_stopHeld = (volatile bool *)calloc(_count, sizeof(bool));
+	_snapshots = (MSActionCallback *)calloc(_count, sizeof(MSActionCallback));
+	_tickedIn = (unsigned long *)calloc(_count, sizeof(unsigned long));
+	_triggered = (int *)calloc(_count, sizeof(int));
+	_hop = (int *)calloc(_count, sizeof(int));
+	_payload = (void **)calloc(_count, sizeof(void *));
+	_handedOver = (bool *)calloc(_count, sizeof(bool));
+	_ticked = (bool *)calloc(_count, sizeof(bool));
+	_oneShot = (bool *)calloc(_count, sizeof(bool));
+	_canStarts = (MSCanStartCallback *)calloc(_count, sizeof(MSCanStartCallback));
+	_blockers = (uint64_t *)calloc(_count, sizeof(uint64_t));
+	// a start, a tick and a stop per action and pass at most
+	_deferred = (MSSchedCall *)calloc(_count * MS_SCHED_PHASES_COUNT, sizeof(MSSchedCall));
+
+	for (int i = 0; i < _count; i++)
+	{
+		Action *a = &(*_list).availableActions[i];
+		_pos[i] = -1;
+		_priority[i] = MS_SCHED_PRIORITY_NORMAL;
+		_worker[i] = MS_SCHED_WORKER_NONE;
+
+		_starts[i] = (*a).start;
+		_ticks[i] = (*a).tick;
+		_stops[i] = (*a).stop;
+		_canStarts[i] = (*a).canStart;
+
+		// the running set relies on seeing every start and stop
+		(*a).start = &_start;
+		(*a).tick = &_tick;
+		(*a).stop = &_stop;
+		(*a).canStart = &_canStart;
+	}
+}
+
+// Requests
+
+static void _schedule(int i)
+{
+	scheduleAction(_list, &(*_list).availableActions[i]);
+	_flags[i] |= MS_SCHED_FLAG_QUEUED;
+	_touch(i, MS_SCHED_FLAG_REQUESTED);
+	_rescheduled = true;
+}
+
+static void _requestStop(int i)
+{
+	Action *a = &(*_list).availableActions[i];
+	if (_isRunning((*a).state) && _stopRequestedAt[i] == 0)
+	{
+		_stopRequestedAt[i] = esp_timer_get_time();
+	}
+	requestStop(_list, a);
+	_flags[i] &= ~MS_SCHED_FLAG_QUEUED;
+	_touch(i, MS_SCHED_FLAG_REQUESTED);
+}
+
+// Ends the current run of the action as if its duration had expired:
+// the library runs stop, sets lst and keeps a frozen action queued, so
+// the next run comes due ti later. A stop request would take a frozen
+// action out of the list instead. The duration of this run is cut to
+// the time it has run (td is application owned, like for
+// ms_sched_touch) and restored when it stops. Actions without a
+// duration have no expiry to bring forward and are stopped
+static void _end(int i)
+{
+	Action *a = &(*_list).availableActions[i];
+	if (!_isRunning((*a).state))
+	{
+		return;
+	}
+
+	if ((*a).td == 0)
+	{
+		_requestStop(i);
+		return;
+	}
+
+	if (_stopRequestedAt[i] == 0)
+	{
+		_stopRequestedAt[i] = esp_timer_get_time();
+	}
+
+	if (!_ended[i])
+	{
+		_ended[i] = true;
+		_endedTd[i] = (*a).td;
+	}
+
+	// at least 1 ms; 0 would mean no duration
+	uint32_t ran = _msSince((*a).st, esp_timer_get_time());
+	(*a).td = ran > 0 ? ran : 1;
+	_cutTd[i] = (*a).td;
+	_touch(i, MS_SCHED_FLAG_REQUESTED);
+	_rescheduled = true;
+}
+
+static void _touchIndex(int i)
+{
+	if (_pos[i] >= 0)
+	{
+		_touch(i, 0);
+	}
+}
+
+static void _tickNow(int i)
+{
+	_flags[i] |= MS_SCHED_FLAG_WOKEN;
+	_touchIndex(i);
+}
+
+static void _trigger(int i, void *payload)
+{
+	_payload[i] = payload;
+	if ((_flags[i] & MS_SCHED_FLAG_TRIGGERED) == 0)
+	{
+		_flags[i] |= MS_SCHED_FLAG_TRIGGERED;
+		_triggered[_triggeredCount++] = i;
+	}
+}
+
+static void _apply(int i, int type, void *payload)
+{
+	switch (type)
+	{
+	case MS_SCHED_REQUEST_SCHEDULE:
+		_schedule(i);
+		break;
+	case MS_SCHED_REQUEST_STOP:
+		_requestStop(i);
+		break;
+	case MS_SCHED_REQUEST_TOUCH:
+		_touchIndex(i);
+		break;
+	case MS_SCHED_REQUEST_TRIGGER:
+		_trigger(i, payload);
+		break;
+	case MS_SCHED_REQUEST_END:
+		_end(i);
+		break;
+	case MS_SCHED_REQUEST_TICK:
+		_tickNow(i);
+		break;
+	}
+}
+
+// call with _mux held
+static void _enqueue(int i, int type, void *payload)
+{
+	if (_requestsCount < MS_SCHED_REQUESTS_SIZE)
+	{
+		_requests[_requestsCount].index = i;
+		_requests[_requestsCount].type = type;
+		_requests[_requestsCount].payload = payload;
+		_requestsCount++;
+	}
+}
+
+// Applies the request right away on the loop task;
+// queues it for the next pass on any other task
+static void _request(int i, int type, void *payload)
+{
+	if (i < 0)
+	{
+		return;
+	}
+
+	if (ms_sched_is_loop_task())
+	{
+		_apply(i, type, payload);
+	}
+	else
+	{
+		portENTER_CRITICAL(&_mux);
+		_enqueue(i, type, payload);
+		portEXIT_CRITICAL(&_mux);
+	}
+
+	ms_sched_wake();
+}
+
+// Queues the request from an interrupt handler for the next pass
+static void _requestFromIsr(int i, int type, void *payload)
+{
+	if (i < 0)
+	{
+		return;
+	}
+
+	portENTER_CRITICAL_ISR(&_mux);
+	_enqueue(i, type, payload);
+	portEXIT_CRITICAL_ISR(&_mux);
+
+	ms_sched_wake_from_isr();
+}
+
+static void _applyRequests()
+{
+	MSSchedRequest pending[MS_SCHED_REQUESTS_SIZE];
+
+	portENTER_CRITICAL(&_mux);
+	int count = _requestsCount;
+	for (int r = 0; r < count; r++)
+	{
+		pending[r] = _requests[r];
+	}
+	_requestsCount = 0;
+	portEXIT_CRITICAL(&_mux);
+
+	for (int r = 0; r < count; r++)
+	{
+		_apply(pending[r].index, pending[r].type, pending[r].payload);
+	}
+}
+
+void ms_sched_schedule(Action *a)
+{
+	_request(_indexOf(a), MS_SCHED_REQUEST_SCHEDULE, nullptr);
+}
+
+void ms_sched_stop(Action *a)
+{
+	_request(_indexOf(a), MS_SCHED_REQUEST_STOP, nullptr);
+}
+
+// Ends the running action early, keeping it scheduled for its next run
+void ms_sched_end(Action *a)
+{
+	_request(_indexOf(a), MS_SCHED_REQUEST_END, nullptr);
+}
+
+// Recalculates the deadline of an action after its
+// ti/td/to fields have been changed by the application
+void ms_sched_touch(Action *a)
+{
+	_request(_indexOf(a), MS_SCHED_REQUEST_TOUCH, nullptr);
+}
+
+// Runs the action within the current cycle - right after the pass
+// in progress, or on the next ms_sched_run when called outside of one.
+// The payload is available to its callbacks through ms_sched_payload
+void ms_sched_trigger(Action *a, void *payload)
+{
+	_request(_indexOf(a), MS_SCHED_REQUEST_TRIGGER, payload);
+}
+
+// Makes the next tick of the running action due right away, for
+// actions ticked when they have work (ms_sched_set_tick_interval
+// bounds the wait in between)
+void ms_sched_tick_now(Action *a)
+{
+	_request(_indexOf(a), MS_SCHED_REQUEST_TICK, nullptr);
+}
+
+void ms_sched_tick_now_from_isr(Action *a)
+{
+	_requestFromIsr(_indexOf(a), MS_SCHED_REQUEST_TICK, nullptr);
+}
+
+void *ms_sched_payload(Action *a)
+{
+	return _payload[_indexOf(a)];
+}
+
+static void _pass(MSSchedTime now)
+{
+	_inPass = true;
+	_rescheduled = false;
+	_passTime = now;
+	doQueueActions(_list, _toMs(now));
+	_inPass = false;
+	_runDeferred();
+}
+
+// Runs start, tick and stop of a triggered action back to back on the
+// loop task. An action the library already handles (or which refuses
+// to start) is left to the next run of the library instead, scheduled
+// for this trigger only if it is not in the list; the payload goes to
+// the first of its runs which ticks and to no other
+static void _runTriggered(int i, MSSchedTime now)
+{
+	Action *a = &(*_list).availableActions[i];
+
+	if ((*a).state != MS_NON_ACTIVE || !_canStart(a))
+	{
+		// a tick made before this trigger does not count
+		_ticked[i] = false;
+		if (!_handedOver[i])
+		{
+			_handedOver[i] = true;
+			if ((*a).state == MS_NON_ACTIVE)
+			{
+				_oneShot[i] = (*a).frozen && (_flags[i] & MS_SCHED_FLAG_QUEUED) == 0;
+				_schedule(i);
+			}
+		}
+		return;
+	}
+
+	(*a).state = MS_RUNNING;
+	(*a).st = _toMs(now);
+	_setRunning(i, true);
+
+	_call(i, MS_SCHED_PHASE_START, _starts[i], a);
+	_call(i, MS_SCHED_PHASE_TICK, _ticks[i], a);
+	_call(i, MS_SCHED_PHASE_STOP, _stops[i], a);
+
+	_setRunning(i, false);
+	(*a).lst = _toMs(now);
+	(*a).state = MS_NON_ACTIVE;
+	_payload[i] = nullptr;
+}
+
+// Follows triggers and schedule requests made during the pass so
+// chains like read -> interpret -> actuate complete in one cycle
+static void _follow(MSSchedTime now)
+{
+	for (int hop = 0; hop < MS_SCHED_MAX_HOPS && (_triggeredCount > 0 || _rescheduled); hop++)
+	{
+		_rescheduled = false;
+
+		// actions triggered while running the current ones go in the next hop
+		int count = _triggeredCount;
+		memcpy(_hop, _triggered, sizeof(int) * count);
+		_triggeredCount = 0;
+
+		for (int t = 0; t < count; t++)
+		{
+			int i = _hop[t];
+			_flags[i] &= ~MS_SCHED_FLAG_TRIGGERED;
+			_runTriggered(i, now);
+		}
+
+		if (_rescheduled)
+		{
+			_flushTouched(now);
+			_pass(now);
+		}
+	}
+}
+
+// Moves the ticks of an offloadable action which keeps overrunning its
+// budget off the loop task. Every other action, or one which cannot be
+// moved (already on a worker, single core, no memory), has its tick
+// interval stretched instead: to itself when the action ticks every
+// to ms, the scheduler's tick interval when it ticks on every pass
+static void _demote(int i)
+{
+	Action *a = &(*_list).availableActions[i];
+	uint64_t interval = _max((uint64_t)_tickInterval[i], (uint64_t)_us((*a).to));
+	if (interval >= MS_SCHED_MAX_STRETCH_US)
+	{
+		return;
+	}
+
+	_stats[i].demotions++;
+
+	if (_offloadable[i] && _worker[i] == MS_SCHED_WORKER_NONE && MS_SCHED_DEMOTION_CORE < portNUM_PROCESSORS)
+	{
+		ms_sched_set_worker(a, MS_SCHED_DEMOTION_CORE);
+		if (_worker[i] != MS_SCHED_WORKER_NONE)
+		{
+			ESP_LOGW(MS_SCHED_TAG, "%s: ticks over budget, moved to core %d", (*a).name, MS_SCHED_DEMOTION_CORE);
+			return;
+		}
+	}
+
+	interval = _max(interval, (uint64_t)_overrunDuration[i]) * 2;
+	if (interval > MS_SCHED_MAX_STRETCH_US)
+	{
+		interval = MS_SCHED_MAX_STRETCH_US;
+	}
+
+	if ((*a).to > 0)
+	{
+		// the library only offers a tick every to ms
+		(*a).to = (unsigned long)((interval + 999) / 1000);
+	}
+	else
+	{
+		_tickInterval[i] = (uint32_t)interval;
+	}
+	_stats[i].interval = (uint32_t)interval;
+	_touchIndex(i);
+	ESP_LOGW(MS_SCHED_TAG, "%s: ticks over budget, interval stretched to %u us", (*a).name, (unsigned)interval);
+}
+
+static void _demoteOverrunning()
+{
+	portENTER_CRITICAL(&_mux);
+	bool pending = _demotePending;
+	_demotePending = false;
+	portEXIT_CRITICAL(&_mux);
+
+	if (!pending)
+	{
+		return;
+	}
+
+	for (int i = 0; i < _count; i++)
+	{
+		if (_demoteRequested[i])
+		{
+			_demoteRequested[i] = false;
+			_demote(i);
+		}
+	}
+}
+
+bool ms_sched_run(MSSchedTime now)
+{
+	_applyRequests();
+	_runHeldStops();
+
+	if (!_inPass)
+	{
+		_flushTouched(now);
+	}
+
+	bool due = _heapSize > 0 && !_after(_deadline[_heap[0]], now);
+	if (!due && _triggeredCount == 0)
+	{
+		return false;
+	}
+
+	_cycle++;
+	_stopSeen = false;
+	_passTime = now;
+
+	if (due)
+	{
+		// take every due action out of the heap
+		while (_heapSize > 0 && !_after(_deadline[_heap[0]], now))
+		{
+			int i = _heap[0];
+			_heapRemove(i);
+			_touch(i, MS_SCHED_FLAG_DUE);
+		}
+
+		_pass(now);
+	}
+
+	_follow(now);
+
+	_demoteOverrunning();
+
+	_flushTouched(now);
+
+	if (_stopSeen)
+	{
+		_releaseBlocked(now);
+	}
+
+	return true;
+}
+
+MSSchedTime ms_sched_next_deadline(MSSchedTime now)
+{
+	if (_touchedCount > 0 || _requestsCount > 0 || _triggeredCount > 0)
+	{
+		return now;
+	}
+
+	if (_heapSize == 0)
+	{
+		return now + _us(MS_SCHED_MAX_IDLE_MS);
+	}
+
+	return _deadline[_heap[0]];
+}
+
+// Blocks the loop task until the earliest deadline or until woken
+void ms_sched_wait(MSSchedTime now)
+{
+	MSSchedTime next = ms_sched_next_deadline(now);
+	MSSchedTime tick = _us(portTICK_PERIOD_MS);
+
+	// deadlines closer than one RTOS tick are polled
+	if (next - now < tick)
+	{
+		return;
+	}
+
+	// round up so we never wake before the deadline
+	TickType_t ticks = (TickType_t)((next - now + tick - 1) / tick);
+	ulTaskNotifyTake(pdTRUE, ticks);
+}
+
+// True on the task running ms_sched_run, which owns the
+// Actions library and the Action fields
+bool ms_sched_is_loop_task()
+{
+	return xTaskGetCurrentTaskHandle() == _loopTask;
+}
+
+void ms_sched_wake()
+{
+	if (_loopTask != nullptr)
+	{
+		xTaskNotifyGive(_loopTask);
+	}
+}
+
+void ms_sched_wake_from_isr()
+{
+	if (_loopTask != nullptr)
+	{
+		BaseType_t woken = pdFALSE;
+		vTaskNotifyGiveFromISR(_loopTask, &woken);
+		portYIELD_FROM_ISR(woken);
+	}
+}
+
+void ms_sched_set_budget(Action *a, uint32_t budget)
+{
+	_stats[_indexOf(a)].budget = budget;
+}
+
+// Lets demotion move the ticks of the action to a worker; the ticks
+// of any other action only get a longer interval when they overrun
+void ms_sched_set_offloadable(Action *a, bool offloadable)
+{
+	_offloadable[_indexOf(a)] = offloadable;
+}
+
+void ms_sched_set_priority(Action *a, int priority)
+{
+	_priority[_indexOf(a)] = (unsigned char)priority;
+	_transitionsChanged = true;
+}
+
+// Runs the ticks of the action on a worker task pinned to core;
+// MS_SCHED_WORKER_NONE runs them on the loop task
+void ms_sched_set_worker(Action *a, int core)
+{
+	int i = _indexOf(a);
+	if (core < 0 || core >= portNUM_PROCESSORS)
+	{
+		_worker[i] = MS_SCHED_WORKER_NONE;
+		return;
+	}
+
+	if (_workerQueues[core] == nullptr)
+	{
+		QueueHandle_t queue = xQueueCreate(_count, sizeof(int));
+		if (queue == nullptr)
+		{
+			// keep running the ticks on the loop task
+			_worker[i] = MS_SCHED_WORKER_NONE;
+			return;
+		}
+
+		if (xTaskCreatePinnedToCore(&_runWorker, "ms_sched_worker", MS_SCHED_WORKER_STACK_SIZE, queue, MS_SCHED_WORKER_PRIORITY, nullptr, core) != pdPASS)
+		{
+			vQueueDelete(queue);
+			_worker[i] = MS_SCHED_WORKER_NONE;
+			return;
+		}
+
+		_workerQueues[core] = queue;
+	}
+
+	_worker[i] = core;
+}
+
+// Sets the callback copying what the ticks of the action read of the
+// state owned by the loop task; it runs on the loop task right before
+// each tick, while no tick of the action runs
+void ms_sched_set_snapshot(Action *a, void (*snapshot)(Action *a))
+{
+	_snapshots[_indexOf(a)] = snapshot;
+}
+
+// Declares the actions which keep the action from starting while they
+// run. The relation is one way: the action does not keep them from
+// starting unless they declare it as well
+void ms_sched_set_blocked_by(Action *a, uint64_t blockers)
+{
+	int i = _indexOf(a);
+	_blockers[i] = i < MS_SCHED_MAX_CONFLICT_ACTIONS ? blockers & ~MS_SCHED_BIT(i) : blockers;
+}
+
+// True when none of the blocking actions is running and
+// the canStart callback of the action (if any) agrees
+bool ms_sched_can_start(Action *a)
+{
+	return _canStart(a);
+}
+
+// Ticks the action every interval us instead of every to ms. The
+// action has to be populated with to = 0 so the library offers it a
+// tick on every pass; 0 goes back to to
+void ms_sched_set_tick_interval(Action *a, uint32_t interval)
+{
+	int i = _indexOf(a);
+	_tickInterval[i] = interval;
+	_touchIndex(i);
+}
+
+MSSchedTime ms_sched_now()
+{
+	return esp_timer_get_time();
+}
+
+const MSSchedStats *ms_sched_stats(Action *a)
+{
+	return &_stats[_indexOf(a)];
+}
+
+// Returns the exclusive upper bound of a histogram bucket in us;
+// 0 for the last (unbounded) bucket
+uint32_t ms_sched_histogram_bound(int bucket)
+{
+	return bucket < MS_SCHED_HISTOGRAM_BUCKETS - 1 ? _bucketBounds[bucket] : 0;
+}
+
+// Clears the collected timings, keeping the budgets
+void ms_sched_reset_stats()
+{
+	for (int i = 0; i < _count; i++)
+	{
+		uint32_t budget = _stats[i].budget;
+		uint32_t interval = _stats[i].interval;
+		memset(&_stats[i], 0, sizeof(MSSchedStats));
+		_stats[i].budget = budget;
+		_stats[i].interval = interval;
+	}
+}
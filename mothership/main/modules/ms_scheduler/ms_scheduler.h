@@ -0,0 +1,168 @@
+#ifndef _MS_SCHEDULER_h
+#define _MS_SCHEDULER_h
+#include <stdint.h>
+#include "modules/actions/actions.h"
+
+// microseconds since boot (esp_timer_get_time)
+typedef int64_t MSSchedTime;
+
+// Deadline ordered front end for the Actions library.
+//
+// The loop task owns the library: it calls ms_sched_run every pass and
+// ms_sched_wait in between, which blocks (tickless) until the earliest
+// deadline or until another task or an interrupt wakes it with a
+// request. An action with work arriving from outside (the BLE host
+// queue) ticks through ms_sched_tick_now instead of polling. Times are
+// microseconds of the 64 bit esp_timer clock; the millisecond fields of
+// the library are converted at the boundary. Those fields stay 32 bit
+// and wrap every 49.7 days: the front end only takes differences of
+// them, and the library's own comparisons are as wrap safe as it is.
+//
+// Each action in the execution list sits in a min-heap keyed on the time
+// it next needs the engine (start, tick or stop), derived from its ti,
+// td, to, st and lst fields. A pass where nothing is due costs a single
+// comparison. A pass where anything is due still runs doQueueActions,
+// which walks the whole list and owns the start/stop transitions. An
+// action that neither ticks on an interval (to > 0) nor runs for a
+// bounded td is due on every pass and keeps the loop from sleeping.
+//
+// Actions enter and leave the list through ms_sched_schedule and
+// ms_sched_stop so the heap follows them; ms_sched_end only ends the
+// current run and keeps a frozen action coming due every ti. An action
+// can also be triggered with a payload: it starts, ticks and stops right
+// after the pass that triggered it. Triggered and newly scheduled actions
+// get up to MS_SCHED_MAX_HOPS follow up passes in the same cycle, so
+// read -> interpret -> actuate completes in one loop iteration; no action
+// ticks twice in a cycle. Calls from other tasks are queued and applied
+// at the start of the next pass.
+//
+// Admission is a bitmask check wrapped around canStart: an action does
+// not start while any action in its blocked-by mask runs. The relation
+// is one way; a pair is exclusive both ways only if both declare it.
+//
+// Ticks of an action bound to a worker (a task pinned to a core) run
+// there; start and stop stay on the loop task. A stop due while a tick
+// runs is held until the worker is done (the action cannot start again
+// meanwhile) instead of stalling the loop task. Worker ticks must leave
+// the Action fields and anything else the loop task owns alone: what
+// they read of it is copied by the snapshot callback of the action
+// (ms_sched_set_snapshot) before each tick, and changes are handed over,
+// for example by triggering an action.
+//
+// Within a pass the callbacks run by priority class: those of critical
+// actions as the library walks the list, the others after the walk,
+// normal before best effort. Best effort actions also skip their tick
+// while a start/stop of a critical action is due within
+// MS_SCHED_YIELD_WINDOW_MS. Critical stops later than
+// MS_SCHED_STOP_LATENCY_BOUND_US are counted and logged.
+//
+// Every start/tick/stop call is timed into a per action histogram and
+// counted as an overrun when it exceeds the action's budget. After
+// MS_SCHED_DEMOTE_OVERRUNS overrunning ticks in a row a non critical
+// action is demoted: an offloadable one still on the loop task moves to
+// a worker on MS_SCHED_DEMOTION_CORE, any other gets its tick interval
+// doubled up to MS_SCHED_MAX_STRETCH_US.
+
+// how long an action which was due but did not start (canStart refused)
+// waits before it is evaluated again; any stop re-evaluates it sooner
+#define MS_SCHED_BLOCKED_POLL_MS 50
+
+// upper bound for any deadline so transitions made inside the library
+// are always picked up eventually
+#define MS_SCHED_MAX_IDLE_MS 1000
+
+// best effort ticks are skipped when a critical
+// start/stop is due within this window
+#define MS_SCHED_YIELD_WINDOW_MS 50
+
+// stops taking longer than this from the moment they were due
+// (or requested) are counted as late
+#define MS_SCHED_STOP_LATENCY_BOUND_US 10000
+
+#define MS_SCHED_TAG "ms_sched"
+
+// consecutive ticks over budget before an action is demoted
+#define MS_SCHED_DEMOTE_OVERRUNS 3
+// the core demoted actions are moved to (the loop task runs on 0)
+#define MS_SCHED_DEMOTION_CORE 1
+// longest tick interval demotion stretches to
+#define MS_SCHED_MAX_STRETCH_US 5000000
+
+// ticks run on the loop task
+#define MS_SCHED_WORKER_NONE -1
+
+#define MS_SCHED_WORKER_STACK_SIZE 8192
+#define MS_SCHED_WORKER_PRIORITY 1
+
+// schedule/stop/touch calls from other tasks waiting for the loop task
+#define MS_SCHED_REQUESTS_SIZE 16
+
+// follow up passes per cycle for triggered/scheduled actions
+#define MS_SCHED_MAX_HOPS 4
+
+// blocking sets cover the first 64 actions of the list
+#define MS_SCHED_MAX_CONFLICT_ACTIONS 64
+#define MS_SCHED_BIT(index) ((uint64_t)1 << (index))
+
+#define MS_SCHED_PRIORITY_CRITICAL 0
+#define MS_SCHED_PRIORITY_NORMAL 1
+#define MS_SCHED_PRIORITY_BEST_EFFORT 2
+
+#define MS_SCHED_PHASE_START 0
+#define MS_SCHED_PHASE_TICK 1
+#define MS_SCHED_PHASE_STOP 2
+#define MS_SCHED_PHASES_COUNT 3
+
+// <100us, <250us, <1ms, <2.5ms, <10ms, <25ms, <100ms, >=100ms
+#define MS_SCHED_HISTOGRAM_BUCKETS 8
+
+struct MSSchedTiming
+{
+	uint32_t hist[MS_SCHED_HISTOGRAM_BUCKETS]; // call count per latency bucket
+	uint32_t count;							   // total calls
+	uint32_t max;							   // longest call in us
+	uint64_t total;							   // sum of all call durations in us
+};
+
+struct MSSchedStats
+{
+	MSSchedTiming phases[MS_SCHED_PHASES_COUNT];
+	uint32_t budget;   // max duration of a single call in us; 0 - no budget
+	uint32_t overruns; // calls which took longer than the budget
+	uint32_t yields;   // ticks skipped in favour of critical actions
+	uint32_t busy;	   // ticks skipped because the worker was still running the previous one
+	uint32_t stopMax;  // longest time from a stop being due to the stop call in us
+	uint32_t stopLate; // stops which took longer than MS_SCHED_STOP_LATENCY_BOUND_US
+	uint32_t demotions; // times the action was demoted for overrunning
+	uint32_t interval;	// tick interval in us after demotion; 0 - not stretched
+};
+
+void ms_sched_init(ActionsList *list);
+void ms_sched_schedule(Action *a);
+void ms_sched_stop(Action *a);
+void ms_sched_end(Action *a);
+void ms_sched_touch(Action *a);
+void ms_sched_trigger(Action *a, void *payload);
+void ms_sched_tick_now(Action *a);
+void ms_sched_tick_now_from_isr(Action *a);
+void *ms_sched_payload(Action *a);
+bool ms_sched_run(MSSchedTime now);
+MSSchedTime ms_sched_next_deadline(MSSchedTime now);
+void ms_sched_wait(MSSchedTime now);
+MSSchedTime ms_sched_now();
+void ms_sched_wake();
+void ms_sched_wake_from_isr();
+bool ms_sched_is_loop_task();
+void ms_sched_set_budget(Action *a, uint32_t budget);
+void ms_sched_set_priority(Action *a, int priority);
+void ms_sched_set_offloadable(Action *a, bool offloadable);
+void ms_sched_set_worker(Action *a, int core);
+void ms_sched_set_tick_interval(Action *a, uint32_t interval);
+void ms_sched_set_snapshot(Action *a, void (*snapshot)(Action *a));
+void ms_sched_set_blocked_by(Action *a, uint64_t blockers);
+bool ms_sched_can_start(Action *a);
+const MSSchedStats *ms_sched_stats(Action *a);
+uint32_t ms_sched_histogram_bound(int bucket);
+void ms_sched_reset_stats();
+
+#endif
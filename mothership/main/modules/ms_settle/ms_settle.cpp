@@ -0,0 +1,44 @@
+#include "ms_settle.h"
+
+void ms_settle_reset(MSSettle *s, int64_t now)
+{
+	(*s).head = 0;
+	(*s).count = 0;
+	(*s).startedAt = now;
+	(*s).time = 0;
+	(*s).settled = false;
+}
+
+// Adds a reading; returns whether the sensor has settled
+bool ms_settle_push(MSSettle *s, int value, int64_t now)
+{
+	(*s).values[(*s).head] = value;
+	(*s).head = ((*s).head + 1) % MS_SETTLE_WINDOW;
+	if ((*s).count < MS_SETTLE_WINDOW)
+	{
+		(*s).count++;
+	}
+
+	if ((*s).settled || (*s).count < MS_SETTLE_WINDOW)
+	{
+		return (*s).settled;
+	}
+
+	int64_t sum = 0;
+	int64_t squares = 0;
+	for (int i = 0; i < MS_SETTLE_WINDOW; i++)
+	{
+		sum += (*s).values[i];
+		squares += (int64_t)(*s).values[i] * (*s).values[i];
+	}
+
+	// n * variance * n, kept in integers
+	int64_t spread = MS_SETTLE_WINDOW * squares - sum * sum;
+	if (spread <= (int64_t)MS_SETTLE_VARIANCE * MS_SETTLE_WINDOW * MS_SETTLE_WINDOW)
+	{
+		(*s).settled = true;
+		(*s).time = (uint32_t)((now - (*s).startedAt) / 1000);
+	}
+
+	return (*s).settled;
+}
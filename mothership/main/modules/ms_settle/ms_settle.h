@@ -0,0 +1,32 @@
+#ifndef _MS_SETTLE_h
+#define _MS_SETTLE_h
+#include <stdint.h>
+
+// Settling detection of a sensor after power on.
+//
+// The readings taken while the sensor is powered are pushed one by
+// one; the detector keeps the last MS_SETTLE_WINDOW of them and
+// reports the sensor as settled once their variance drops to
+// MS_SETTLE_VARIANCE. The time from the reset (power on) to that
+// moment is kept as the settle time.
+
+// readings the variance is taken over (1s of 200ms ticks)
+#define MS_SETTLE_WINDOW 5
+
+// largest variance of a settled sensor in raw counts^2 (16^2)
+#define MS_SETTLE_VARIANCE 256
+
+struct MSSettle
+{
+	int values[MS_SETTLE_WINDOW];
+	int head;
+	int count;
+	int64_t startedAt; // us
+	uint32_t time;	   // settle time in ms; 0 - not settled (yet)
+	bool settled;
+};
+
+void ms_settle_reset(MSSettle *s, int64_t now);
+bool ms_settle_push(MSSettle *s, int value, int64_t now);
+
+#endif
@@ -1,4 +1,3 @@
-
 #include "nvs_flash.h"
 #include "modules/actions/actions.h"
 #include <Wire.h>
@@ -14,6 +13,15 @@
 #include <ArduinoJson.h>
 #include "esp_log.h"
 #include "modules/ms_bluetooth/ms_bluetooth.h"
+#include "modules/ms_scheduler/ms_scheduler.h"
+#include "modules/ms_adc/ms_adc.h"
+#include "modules/ms_filter/ms_filter.h"
+#include "modules/ms_history/ms_history.h"
+#include "modules/ms_settle/ms_settle.h"
+#include "modules/ms_interpret/ms_interpret.h"
+#include "modules/ms_calibration/ms_calibration.h"
+#include "modules/ms_display/ms_display.h"
+#include "modules/ms_layout/ms_layout.h"
 #include "mothership_main.h"
 
 #ifdef __AVR_ATmega328P__ || __AVR_ATmega168__
@@ -30,32 +38,10 @@
 const char *MS_OFF_STRING = "OFF";
 const char *MS_ON_STRING = "ON";
 const char *MS_BACK_BUTTON_PROMPT = "B1 - Back";
-const char *MS_READING_PROMPT_TEXT = "Reading...";
 const char *MS_STARTING_PROMPT_TEXT = "Starting...";
 
 const char *MS_IRRIGATE_UNTIL_EXPIRY_KEY = "iue";
 
-const char *MS_FAR_ACTIVE_SETTING_KEY = "far-active";
-const char *MS_MID_ACTIVE_SETTING_KEY = "mid-active";
-const char *MS_NEAR_ACTIVE_SETTING_KEY = "near-active";
-
-const char *MS_FAR_WET_SETTING_KEY = "wet-far";
-const char *MS_MID_WET_SETTING_KEY = "wet-mid";
-const char *MS_NEAR_WET_SETTING_KEY = "wet-near";
-
-const char *MS_FAR_DRY_SETTING_KEY = "dry-far";
-const char *MS_MID_DRY_SETTING_KEY = "dry-mid";
-const char *MS_NEAR_DRY_SETTING_KEY = "dry-near";
-
-const char *MS_APV_NEAR_SETTING_KEY = "n-apv";
-const char *MS_DAPV_NEAR_SETTING_KEY = "n-dapv";
-
-const char *MS_APV_MID_SETTING_KEY = "m-apv";
-const char *MS_DAPV_MID_SETTING_KEY = "m-dapv";
-
-const char *MS_APV_FAR_SETTING_KEY = "f-apv";
-const char *MS_DAPV_FAR_SETTING_KEY = "f-dapv";
-
 const char *MS_PUMP_MAX_DURATION_SETTING_KEY = "p-max";
 const char *MS_PUMP_REACT_INT_DURATION_SETTING_KEY = "p-react";
 
@@ -73,6 +59,8 @@ DynamicJsonDocument doc2(1024);
 
 unsigned char stringPool1024b1[1024];
 unsigned char stringPool1024b2[1024];
+
+unsigned char stringPool4096b1[4096];
 unsigned char stringPool1024b3[1024];
 unsigned char stringPool1024b4[1024];
 
@@ -166,6 +154,19 @@ char stringPool5b4[5];
 #define SCREEN_ADDRESS 0x3C ///< See datasheet for Address; 0x3D for 128x64, 0x3C for 128x32
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
 
+// I2C clock of the display (the Adafruit library uses the
+// same while sending); the flush task is the only bus user
+#define MS_DISPLAY_I2C_CLOCK 400000
+// data bytes per I2C transfer (one more is the control byte)
+#ifdef I2C_BUFFER_LENGTH
+#define MS_DISPLAY_I2C_CHUNK (I2C_BUFFER_LENGTH - 1)
+#else
+#define MS_DISPLAY_I2C_CHUNK 31
+#endif
+// changed spans sent per flush; more than that and the whole frame is sent
+#define MS_DISPLAY_MAX_SPANS 32
+#define MS_DISPLAY_FRAME_SIZE (SCREEN_WIDTH * SCREEN_HEIGHT / 8)
+
 #ifdef ARDUINO_ARCH_ESP32
 
 #define BUTTON_1_LOW 500
@@ -247,33 +248,76 @@ Preferences preferences;
 
 #endif
 
-#define SENSORS_COUNT 3
+// rows of the zones table
+#define ZONES_COUNT 3
 
-#define MS_SENSOR_FAR 0
-#define MS_SENSOR_MID 1
-#define MS_SENSOR_NEAR 2
+// B2-B4 pick a zone; with more zones B4 turns the page
+#define MS_PICKER_BUTTONS 3
 
-#define ACTIONS_COUNT 12
+// zones per home screen page and time per page
+#define MS_HOME_PAGE_SIZE 3
+#define MS_HOME_PAGE_MS 4000
 
 // action defines
 #define READ_SENSORS_ACTION 0
-#define OUTLET_FAR_ACTION 1
-#define OUTLET_MID_ACTION 2
-#define OUTLET_NEAR_ACTION 3
-#define PUMP_ACTION 4
-#define DRAW_UI_ACTION 5
-#define WIFI_ACTION 6
-#define INTERPRET_SENSOR_DATA_ACTION 7
-#define CALIBRATE_SENSOR_ACTION 8
-#define BLE_ACTION 9
-#define CLEAN_PUMP_ACTION 10
-#define IRRIGATE_ACTION 11
+// one outlet action per zone, farthest zone first
+#define FIRST_OUTLET_ACTION 1
+#define OUTLET_ACTION(zone) (FIRST_OUTLET_ACTION + ZONES_COUNT - 1 - (zone))
+#define PUMP_ACTION (1 + ZONES_COUNT)
+#define DRAW_UI_ACTION (2 + ZONES_COUNT)
+#define WIFI_ACTION (3 + ZONES_COUNT)
+#define INTERPRET_SENSOR_DATA_ACTION (4 + ZONES_COUNT)
+#define CALIBRATE_SENSOR_ACTION (5 + ZONES_COUNT)
+#define BLE_ACTION (6 + ZONES_COUNT)
+#define CLEAN_PUMP_ACTION (7 + ZONES_COUNT)
+#define IRRIGATE_ACTION (8 + ZONES_COUNT)
+#define APPLY_SETTINGS_ACTION (9 + ZONES_COUNT)
+
+#define ACTIONS_COUNT (10 + ZONES_COUNT)
+
+// the pump runs as a child of whichever outlet is open
+#define OUTLET_ACTIONS ((MS_SCHED_BIT(ZONES_COUNT) - 1) << FIRST_OUTLET_ACTION)
 
 // end of action defines
 
 // #undef DEBUG
 #define DEBUG
 
+// the loop sleeps until the next action deadline
+// instead of spinning; comment out to busy-loop
+#define MS_TICKLESS_LOOP
+
+// UI and web server ticks run on a worker on core 1;
+// the loop task keeps the control actions on core 0
+#ifndef CONFIG_FREERTOS_UNICORE
+#define MS_MULTICORE_EXECUTOR
+#endif
+
+// the display flush task runs next to the UI worker
+#define MS_DISPLAY_FLUSH_STACK_SIZE 4096
+#define MS_DISPLAY_FLUSH_PRIORITY 1
+#ifdef MS_MULTICORE_EXECUTOR
+#define MS_DISPLAY_FLUSH_CORE 1
+#else
+#define MS_DISPLAY_FLUSH_CORE 0
+#endif
+
+// the sensors read interval outside of watering follows the drying
+// rate of the zones; comment out to always use settings.sid
+#define MS_ADAPTIVE_SENSORS_INTERVAL
+
+// the adaptive interval is bounded by settings.siw and settings.sid
+// the next read is due after this fraction of the time
+// a zone is predicted to need to reach its threshold
+#define MS_SENSORS_PREDICTION_FRACTION 0.5f
+
+// readings in a zone's history before its slope is trusted
+#define MS_SENSORS_MIN_HISTORY 4
+
+// ticks of a sensors read before it can end early,
+// also when no zone is active and nothing has to settle
+#define MS_SENSORS_MIN_READINGS MS_SETTLE_WINDOW
+
 // Structures
 
 struct MSScreenBox
@@ -319,12 +363,27 @@ const int MS_SENSOR_CALIBRATION_READ_WET_STATE = 4;
 const int MS_SENSOR_CALIBRATION_STORE_VALUES_STATE = 5;
 const int MS_SENSOR_CALIBRATION_FINAL_STATE = 6;
 
+// time a calibration point is read for and the
+// interval of the batches of readings taken meanwhile
+#define MS_SENSOR_CALIBRATION_READ_MS 10000
+#define MS_SENSOR_CALIBRATION_TICK_MS 20
+
+// boot calibration reads all zones at once until every one of them
+// has settled and its mean is known to MS_BOOT_CALIBRATION_ERROR
+// counts (standard error), but for no longer than MS_BOOT_CALIBRATION_MAX_MS
+#define MS_BOOT_CALIBRATION_MIN_READINGS 256
+#define MS_BOOT_CALIBRATION_ERROR 1
+#define MS_BOOT_CALIBRATION_MAX_MS 30000
+#define MS_BOOT_CALIBRATION_DRAW_MS 250
+
 struct SensorsThresholdEditState
 {
-	int sensorCode = -1;
+	int sensorCode = -1; // zone being edited
 	int state = -1;
-	int pin = -1;
+	int page = 0; // page of the zone pickers
 	char *settingKey;
+	MSCalibration calibration; // readings of the calibration point being read
+	MSSettle settle;		   // settling of the sensor before they are taken
 } sensorEditState;
 
 struct MSysSettings
@@ -337,30 +396,89 @@ struct MSysSettings
 	bool iue = false;			   // Irrigate until action expiry; false if pump is deactivated once a sensor returns signal; true otherwise;
 } settings;
 
-struct Sensor
-{
-	int wet;   // completely wet reading
-	int dry;   // completely dry reading
-	int value; // current reading
-	int ai;	   // action index
-	int p;	   // humidity percentage
-	int apv;
-	int dapv;
-	bool active = true;
-	char name[5];
+// how long a web request waits for the loop task to apply its settings
+// and how many edits can wait for it
+#define MS_SETTINGS_APPLY_TIMEOUT_MS 1000
+#define MS_SETTINGS_EDITS_SIZE 4
+
+// Settings received by the web server, applied by the settings action
+// on the loop task; -1 leaves a value unchanged
+struct MSSettingsEdit
+{
+	uint32_t id;
+	int apv[ZONES_COUNT];
+	int dapv[ZONES_COUNT];
+	int active[ZONES_COUNT];
+	long pd;
+	long pi;
+	int iue;
+};
+
+// Each request queues a copy of its edit; the settings action applies
+// the queued edits in order, stores the id of the last one and gives
+// the signal, so a request whose edit is applied late is not confused
+// with the next one
+struct MSSettingsEdits
+{
+	QueueHandle_t queue = nullptr;
+	SemaphoreHandle_t applied = nullptr;
+	volatile uint32_t appliedId = 0;
+	uint32_t lastId = 0; // owned by the web server
+} settingsEdits;
+
+// An irrigation zone: a sensor and the valve it controls
+struct MSZone
+{
+	const char *name;	   // JSON key and UI caption
+	const char *label;	   // one letter caption on the home screen
+	const char *outlet;	   // name of the outlet action
+	int sensorPin;
+	int valvePin;
+	const char *activeKey; // preference keys
+	const char *wetKey;
+	const char *dryKey;
+	const char *apvKey;
+	const char *dapvKey;
+};
+
+const MSZone zones[ZONES_COUNT] = {
+	{"near", "N", "valve-near", PIN_NEAR, PIN_VALVE_NEAR, "near-active", "wet-near", "dry-near", "n-apv", "n-dapv"},
+	{"mid", "M", "valve-mid", PIN_MID, PIN_VALVE_MID, "mid-active", "wet-mid", "dry-mid", "m-apv", "m-dapv"},
+	{"far", "F", "valve-far", PIN_FAR, PIN_VALVE_FAR, "far-active", "wet-far", "dry-far", "f-apv", "f-dapv"}};
+
+// State of the zones, one array per field
+struct MSZonesState
+{
+	int value[ZONES_COUNT];	  // current reading
+	int p[ZONES_COUNT];		  // humidity percentage (moving average of the readings)
+	int wet[ZONES_COUNT];	  // completely wet reading
+	int dry[ZONES_COUNT];	  // completely dry reading
+	uint32_t scale[ZONES_COUNT]; // percent per raw count (see ms_interpret_scale)
+	int apv[ZONES_COUNT];	  // the outlet opens below this percentage
+	int dapv[ZONES_COUNT];	  // and closes above this one
+	bool active[ZONES_COUNT]; // zone is irrigated
+	bool v[ZONES_COUNT];	  // outlet valve is open
+	MSHistory h[ZONES_COUNT]; // readings and their aggregates
+	MSSettle st[ZONES_COUNT]; // settling after the sensors are powered
 };
 
 struct SystemState
 {
 	int scr = MS_HOME_SCREEN; // current screen
-	Sensor *s = nullptr;	  // array of sensors and their state
+	MSZonesState *z = nullptr; // state of the zones
 	bool p = false;			  // indicates whether the pump is active
 	bool sa = false;		  // indicates whether the sensors are active
-	bool vn = false;		  // indicates whether the near outlet is open
-	bool vm = false;		  // indicates whether the mid outlet is open
-	bool vf = false;		  // indicates whether the far outlet is open
+	bool pt = false;		  // indicates whether the processes screen shows timings
 } state;
 
+// ticks of the current sensors read
+int sensorsReadings = 0;
+
+// Bumped (touchState) by everything that changes what the
+// screens show; the UI only redraws when it has changed
+uint32_t stateVersion = 0;
+portMUX_TYPE stateVersionMux = portMUX_INITIALIZER_UNLOCKED;
+
 // An array used for iterating over scheduled
 // actions and executing them
 Action *availableActions = nullptr;
@@ -372,6 +490,7 @@ struct MSScreen
 	void (*handleButtons)(int buttonValue);
 	void (*drawUI)(Action *a);
 	int code;
+	unsigned long refresh; // ms; also redraw every refresh ms (time dependent screens), 0 - only on change
 };
 
 // An array containing the available screens
@@ -382,13 +501,121 @@ struct ButtonState
 	int value = 0;
 	bool hasChanged = false;
 } button;
+
+// Frame times of the UI in us: drawing a screen into the
+// display buffer and handing the buffer to the flush task
+struct MSFrameStats
+{
+	uint32_t frames = 0;
+	uint32_t renderMax = 0;
+	uint64_t renderTotal = 0;
+	uint32_t submitMax = 0;
+	uint64_t submitTotal = 0;
+	uint32_t skipped = 0; // ticks where the display was already current
+} frameStats;
+
+// flush times in us and bytes sent
+struct MSDisplayStats
+{
+	uint32_t flushes = 0;
+	uint32_t dropped = 0;
+	uint32_t flushMax = 0;
+	uint64_t flushTotal = 0;
+	uint64_t bytesTotal = 0;
+};
+
+// Display service. Screens draw into the buffer of the display and
+// submitDisplay copies it into the back frame, then swaps it with the
+// pending one and wakes the flush task, which owns the I2C bus after
+// initDisplay. The task swaps pending with front and sends what changed
+// against flushed. The three frames are only ever swapped by index, so
+// the spinlock is held for a few assignments and never for a copy; a
+// frame submitted while another is still pending replaces it (dropped).
+struct MSDisplayService
+{
+	TaskHandle_t task = nullptr;
+	portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+	uint8_t frames[3][MS_DISPLAY_FRAME_SIZE];
+	int back = 0; // owned by submitDisplay
+	int pending = 1; // swapped under mux
+	int front = 2; // owned by the flush task
+	bool hasPending = false;
+	bool hasFlushed = false;
+	uint8_t flushed[MS_DISPLAY_FRAME_SIZE]; // as on the display
+	MSDisplayStats stats; // guarded by mux
+} displayService;
+
+// Bounds of the texts the screens print (all in DEFAULT_FONT)
+MSLayoutCache layoutCache;
+
+// The frame on the display: the state version and
+// screen it was drawn from and when it was drawn
+struct MSDrawnFrame
+{
+	bool valid = false;
+	uint32_t version = 0;
+	int screen = 0;
+	unsigned long at = 0;
+} drawnFrame;
+
+// The action states (changed by the Actions library) and peers count
+// (changed by the BLE host task) as last seen by the UI; these are
+// compared every frame instead of bumping the version where they change
+struct MSWatchedState
+{
+	int peers = 0;
+	int actions[ACTIONS_COUNT];
+} watchedState;
+
+// What the screens show, copied from the state owned by the loop task
+// by snapshotScreen before each tick of the UI, which may run on a
+// worker; drawing reads nothing else of that state
+struct MSScreenState
+{
+	uint32_t version = 0; // stateVersion when copied
+	int scr = MS_HOME_SCREEN;
+	bool p = false;
+	bool sa = false;
+	bool pt = false;
+	int zp[ZONES_COUNT]; // zones state
+	int wet[ZONES_COUNT];
+	int dry[ZONES_COUNT];
+	int apv[ZONES_COUNT];
+	int dapv[ZONES_COUNT];
+	bool active[ZONES_COUNT];
+	bool v[ZONES_COUNT];
+	MSysSettings settings;
+	unsigned long sd = 0; // duration of a sensors read
+	int zone = -1;		  // sensorEditState: zone, page, calibration and its spread
+	int page = 0;
+	int calibration = -1;
+	int spread = 0;
+	int actions[ACTIONS_COUNT]; // action states
+	bool canCalibrate = false;
+	bool canIrrigate = false;
+	bool canClean = false;
+	bool bleActive = false;
+	int peers = 0;
+	MSSchedStats stats[ACTIONS_COUNT]; // copied for the timings only
+} screenState;
 // end of structures
 
 // function declarations
-int fixedAnalogRead(int pin);
+bool fixedAnalogRead(int pin, int *value);
+
+void touchState()
+{
+	portENTER_CRITICAL(&stateVersionMux);
+	stateVersion++;
+	portEXIT_CRITICAL(&stateVersionMux);
+}
 void storeSetPreferences();
 int readButton();
 void setActionsList();
+void setActionBudgets();
+void setActionPriorities();
+void setActionWorkers();
+void setActionBlockers();
 // end of function declarations
 
 // Helpers
@@ -411,25 +638,183 @@ void joinStrings(char **source, int size, char *glue, char *target, int skipGlue
 	}
 }
 
-void initCanvas(GFXcanvas16 *c)
+void initCanvas(Adafruit_GFX *c)
 {
 	(*c).setFont(&DEFAULT_FONT);
 	(*c).setTextColor(SSD1306_WHITE);
+	(*c).setTextSize(MS_FONT_TEXT_SIZE_NORMAL);
 }
 
-void printPositionedText(GFXcanvas16 *canvas, const char *text, int x, int y)
+// Sets the text size of the canvas and the width and height of
+// text at it; measured once per text and size (see ms_layout)
+void _textBounds(Adafruit_GFX *canvas, const char *text, int textSize, uint16_t *w, uint16_t *h)
+{
+	(*canvas).setTextSize(textSize);
+	if (ms_layout_find(&layoutCache, text, textSize, w, h))
+	{
+		return;
+	}
+
+	int16_t x, y;
+	(*canvas).getTextBounds(text, 0, 0, &x, &y, w, h);
+	ms_layout_store(&layoutCache, text, textSize, *w, *h);
+}
+
+// Screens draw straight into the 1-bpp buffer of the display
+// (1 KB); the caller sends it with submitDisplay()
+Adafruit_GFX *beginFrame(Adafruit_SSD1306 *display)
+{
+	(*display).clearDisplay();
+	initCanvas(display);
+	return display;
+}
+
+// Sends length bytes of data into the given column/page window of the
+// display (horizontal addressing, so the data wraps within the window)
+void _sendWindow(const uint8_t *data, int length, uint8_t startColumn, uint8_t endColumn, uint8_t startPage, uint8_t endPage)
+{
+	Wire.beginTransmission(SCREEN_ADDRESS);
+	Wire.write((uint8_t)0x00); // command stream
+	Wire.write((uint8_t)SSD1306_COLUMNADDR);
+	Wire.write(startColumn);
+	Wire.write(endColumn);
+	Wire.write((uint8_t)SSD1306_PAGEADDR);
+	Wire.write(startPage);
+	Wire.write(endPage);
+	Wire.endTransmission();
+
+	for (int i = 0; i < length; i += MS_DISPLAY_I2C_CHUNK)
+	{
+		Wire.beginTransmission(SCREEN_ADDRESS);
+		Wire.write((uint8_t)0x40); // data stream
+		Wire.write(&data[i], _min(MS_DISPLAY_I2C_CHUNK, length - i));
+		Wire.endTransmission();
+	}
+}
+
+// Sends what changed in front since the last flush (see ms_display)
+// and returns the bytes that took on the bus. The whole frame is
+// sent the first time and when most of it changed.
+int _flushFront()
+{
+	MSDisplayService *s = &displayService;
+	uint8_t *front = (*s).frames[(*s).front];
+	MSDisplaySpan spans[MS_DISPLAY_MAX_SPANS];
+	int count = -1;
+	if ((*s).hasFlushed)
+	{
+		count = ms_display_diff(front, (*s).flushed, SCREEN_WIDTH, SCREEN_HEIGHT / 8, spans, MS_DISPLAY_MAX_SPANS);
+	}
+
+	// when (nearly) everything changed the full frame costs less
+	if (count == -1 || ms_display_span_bytes(spans, count) >= MS_DISPLAY_FRAME_SIZE)
+	{
+		_sendWindow(front, MS_DISPLAY_FRAME_SIZE, 0, SCREEN_WIDTH - 1, 0, SCREEN_HEIGHT / 8 - 1);
+		memcpy((*s).flushed, front, MS_DISPLAY_FRAME_SIZE);
+		(*s).hasFlushed = true;
+		return MS_DISPLAY_SPAN_OVERHEAD + MS_DISPLAY_FRAME_SIZE;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		MSDisplaySpan span = spans[i];
+		_sendWindow(&front[span.page * SCREEN_WIDTH + span.start], span.end - span.start + 1, span.start, span.end, span.page, span.page);
+	}
+	return ms_display_span_bytes(spans, count);
+}
+
+// Takes the pending frame, if any, and sends it
+void _flushPending()
+{
+	MSDisplayService *s = &displayService;
+	portENTER_CRITICAL(&(*s).mux);
+	bool hasPending = (*s).hasPending;
+	if (hasPending)
+	{
+		int front = (*s).front;
+		(*s).front = (*s).pending;
+		(*s).pending = front;
+		(*s).hasPending = false;
+	}
+	portEXIT_CRITICAL(&(*s).mux);
+
+	if (!hasPending)
+	{
+		return;
+	}
+
+	int64_t startedAt = esp_timer_get_time();
+	int bytes = _flushFront();
+	uint32_t flush = (uint32_t)(esp_timer_get_time() - startedAt);
+
+	portENTER_CRITICAL(&(*s).mux);
+	MSDisplayStats *st = &(*s).stats;
+	(*st).flushes++;
+	(*st).flushTotal += flush;
+	(*st).flushMax = _max((*st).flushMax, flush);
+	(*st).bytesTotal += bytes;
+	portEXIT_CRITICAL(&(*s).mux);
+}
+
+// A consistent copy of the flush statistics for other tasks
+MSDisplayStats displayStats()
+{
+	MSDisplayService *s = &displayService;
+	portENTER_CRITICAL(&(*s).mux);
+	MSDisplayStats stats = (*s).stats;
+	portEXIT_CRITICAL(&(*s).mux);
+	return stats;
+}
+
+void _runDisplayFlush(void *arg)
+{
+	Wire.setClock(MS_DISPLAY_I2C_CLOCK);
+	for (;;)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		_flushPending();
+	}
+}
+
+// Hands the display buffer to the flush task; never waits for the bus.
+// Without the task (it could not be created) the frame is sent here.
+void submitDisplay(Adafruit_SSD1306 *display)
+{
+	MSDisplayService *s = &displayService;
+	memcpy((*s).frames[(*s).back], (*display).getBuffer(), MS_DISPLAY_FRAME_SIZE);
+
+	portENTER_CRITICAL(&(*s).mux);
+	if ((*s).hasPending)
+	{
+		(*s).stats.dropped++;
+	}
+	int back = (*s).back;
+	(*s).back = (*s).pending;
+	(*s).pending = back;
+	(*s).hasPending = true;
+	portEXIT_CRITICAL(&(*s).mux);
+
+	if ((*s).task != nullptr)
+	{
+		xTaskNotifyGive((*s).task);
+	}
+	else
+	{
+		_flushPending();
+	}
+}
+
+void printPositionedText(Adafruit_GFX *canvas, const char *text, int x, int y)
 {
 	(*canvas).setCursor(x, y);
 	(*canvas).print(text);
 }
 
-MSScreenBox printAlignedText(GFXcanvas16 *canvas, const char *text, int textSize, int align = MS_H_CENTER | MS_V_CENTER)
+MSScreenBox printAlignedText(Adafruit_GFX *canvas, const char *text, int textSize, int align = MS_H_CENTER | MS_V_CENTER)
 {
 	int fontCorrection = textSize == MS_FONT_TEXT_SIZE_NORMAL ? FONT_BASELINE_CORRECTION_NORMAL : FONT_BASELINE_CORRECTION_LARGE;
-	int16_t mx, my;
 	uint16_t mw, mh;
-	(*canvas).setTextSize(textSize);
-	(*canvas).getTextBounds(text, 0, 0, &mx, &my, &mw, &mh);
+	_textBounds(canvas, text, textSize, &mw, &mh);
 	(*canvas).setTextColor(SSD1306_WHITE);
 	int16_t x = 0;
 	int16_t y = 0;
@@ -465,7 +850,7 @@ MSScreenBox printAlignedText(GFXcanvas16 *canvas, const char *text, int textSize
 }
 
 MSScreenBox printAlignedTextStack(
-	GFXcanvas16 *canvas,
+	Adafruit_GFX *canvas,
 	char **text,
 	int arraySize,
 	int textSize,
@@ -478,14 +863,12 @@ MSScreenBox printAlignedTextStack(
 
 	int fontCorrection = textSize == MS_FONT_TEXT_SIZE_NORMAL ? FONT_BASELINE_CORRECTION_NORMAL : FONT_BASELINE_CORRECTION_LARGE;
 	boxHeight += spacing * (arraySize - 1) + fontCorrection;
-	(*canvas).setTextSize(textSize);
 
 	char **cpointer = text;
 	for (int i = 0; i < arraySize; i++)
 	{
-		int16_t cx, cy;
 		uint16_t cw, ch;
-		(*canvas).getTextBounds((*cpointer), 0, 0, &cx, &cy, &cw, &ch);
+		_textBounds(canvas, (*cpointer), textSize, &cw, &ch);
 		boxHeight += ch;
 
 		if (cw > boxWidth)
@@ -495,37 +878,6 @@ MSScreenBox printAlignedTextStack(
 		cpointer++;
 	}
 
-	GFXcanvas16 boxCanvas(boxWidth, boxHeight);
-	initCanvas(&boxCanvas);
-	boxCanvas.setTextSize(textSize);
-
-	cpointer = text;
-	int yCoord = fontCorrection; // offset correction due to font
-	int xCoord = 0;
-	for (int i = 0; i < arraySize; i++)
-	{
-		int16_t cx, cy;
-		uint16_t cw, ch;
-		boxCanvas.getTextBounds((*cpointer), 0, 0, &cx, &cy, &cw, &ch);
-
-		switch (align)
-		{
-		case MS_H_LEFT:
-			xCoord = boxWidth / 2 - boxWidth / 2;
-			break;
-		case MS_H_CENTER:
-			xCoord = boxWidth / 2 - cw / 2;
-			break;
-		case MS_H_RIGHT:
-			xCoord = boxWidth - cw;
-			break;
-		}
-
-		printPositionedText(&boxCanvas, (*cpointer), xCoord, yCoord);
-		cpointer++;
-		yCoord += (ch + spacing);
-	}
-
 	int boxX = 0, boxY = 0;
 	int screenWidth = (*canvas).width();
 	int screenHeight = (*canvas).height();
@@ -556,7 +908,35 @@ MSScreenBox printAlignedTextStack(
 		boxY = screenHeight - boxHeight;
 	}
 
-	(*canvas).drawRGBBitmap(boxX, boxY, boxCanvas.getBuffer(), boxWidth, boxHeight);
+	// the box covers whatever was drawn below it
+	(*canvas).fillRect(boxX, boxY, boxWidth, boxHeight, SSD1306_BLACK);
+
+	cpointer = text;
+	int yCoord = fontCorrection; // offset correction due to font
+	int xCoord = 0;
+	for (int i = 0; i < arraySize; i++)
+	{
+		// a cache hit: measured above
+		uint16_t cw, ch;
+		_textBounds(canvas, (*cpointer), textSize, &cw, &ch);
+
+		switch (align)
+		{
+		case MS_H_LEFT:
+			xCoord = boxWidth / 2 - boxWidth / 2;
+			break;
+		case MS_H_CENTER:
+			xCoord = boxWidth / 2 - cw / 2;
+			break;
+		case MS_H_RIGHT:
+			xCoord = boxWidth - cw;
+			break;
+		}
+
+		printPositionedText(canvas, (*cpointer), boxX + xCoord, boxY + yCoord);
+		cpointer++;
+		yCoord += (ch + spacing);
+	}
 
 	return {boxX, boxY, boxWidth, boxHeight};
 	;
@@ -566,99 +946,102 @@ void drawStartingPromptScreen(Adafruit_SSD1306 *display, int remaining)
 {
 	sprintf(stringPool20b1, "(B2 in: %ds)", remaining);
 	char *prompt[] = {"Actions:", "B1 - init", "B2 - start", stringPool20b1};
-	GFXcanvas16 canvas(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&canvas);
-	printAlignedTextStack(&canvas, prompt, 4, DEFAULT_TEXT_SIZE, MS_H_LEFT, MS_H_CENTER | MS_V_CENTER);
-	(*display).drawRGBBitmap(0, 0, canvas.getBuffer(), SCREEN_WIDTH, SCREEN_HEIGHT);
-	(*display).display();
-}
-
-void drawDryValuesScreen(Adafruit_SSD1306 *display)
-{
-	sprintf(stringPool20b1, "Near: %d", state.s[MS_SENSOR_NEAR].dry);
-	sprintf(stringPool20b2, "Mid: %d", state.s[MS_SENSOR_MID].dry);
-	sprintf(stringPool20b3, "Far: %d", state.s[MS_SENSOR_FAR].dry);
-
-	char *message[] = {"Dry values:", stringPool20b1, stringPool20b2, stringPool20b3};
-	GFXcanvas16 canvas(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&canvas);
-	printAlignedTextStack(&canvas, message, 4, DEFAULT_TEXT_SIZE, MS_H_LEFT, MS_H_CENTER | MS_V_CENTER);
-	(*display).drawRGBBitmap(0, 0, canvas.getBuffer(), SCREEN_WIDTH, SCREEN_HEIGHT);
-	(*display).display();
+	Adafruit_GFX *canvas = beginFrame(display);
+	printAlignedTextStack(canvas, prompt, 4, DEFAULT_TEXT_SIZE, MS_H_LEFT, MS_H_CENTER | MS_V_CENTER);
+	submitDisplay(display);
 }
 
-void drawWetValuesScreen(Adafruit_SSD1306 *display)
+// Shows the values of all zones, three at a time, each page for the given time
+void showZoneValuesScreens(Adafruit_SSD1306 *display, char *caption, int *values, int pageTime)
 {
-	sprintf(stringPool20b1, "Near: %d", state.s[MS_SENSOR_NEAR].wet);
-	sprintf(stringPool20b2, "Mid: %d", state.s[MS_SENSOR_MID].wet);
-	sprintf(stringPool20b3, "Far: %d", state.s[MS_SENSOR_FAR].wet);
+	char *pool[] = {stringPool20b1, stringPool20b2, stringPool20b3};
+	for (int first = 0; first < ZONES_COUNT; first += 3)
+	{
+		char *message[] = {caption, stringPool20b1, stringPool20b2, stringPool20b3};
+		int lines = 1;
+		for (int i = first; i < first + 3 && i < ZONES_COUNT; i++)
+		{
+			sprintf(pool[lines - 1], "%s: %d", zones[i].name, values[i]);
+			lines++;
+		}
 
-	char *message[] = {"Wet values:", stringPool20b1, stringPool20b2, stringPool20b3};
-	GFXcanvas16 canvas(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&canvas);
-	printAlignedTextStack(&canvas, message, 4, DEFAULT_TEXT_SIZE, MS_H_LEFT, MS_H_CENTER | MS_V_CENTER);
-	(*display).drawRGBBitmap(0, 0, canvas.getBuffer(), SCREEN_WIDTH, SCREEN_HEIGHT);
-	(*display).display();
+		Adafruit_GFX *canvas = beginFrame(display);
+		printAlignedTextStack(canvas, message, lines, DEFAULT_TEXT_SIZE, MS_H_LEFT, MS_H_CENTER | MS_V_CENTER);
+		submitDisplay(display);
+		delay(pageTime);
+	}
 }
 
 void drawStartingValuesScreen(Adafruit_SSD1306 *display)
 {
-	drawDryValuesScreen(display);
-	delay(5000);
-	drawWetValuesScreen(display);
-	delay(5000);
+	showZoneValuesScreens(display, "Dry values:", (*state.z).dry, 5000);
+	showZoneValuesScreens(display, "Wet values:", (*state.z).wet, 5000);
 	(*display).clearDisplay();
 }
 
 void showTextCaptionScreen(Adafruit_SSD1306 *display, const char *caption)
 {
-	GFXcanvas16 canvas(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&canvas);
-	printAlignedText(&canvas, caption, MS_FONT_TEXT_SIZE_LARGE, MS_V_CENTER | MS_H_CENTER);
-	(*display).drawRGBBitmap(0, 0, canvas.getBuffer(), SCREEN_WIDTH, SCREEN_HEIGHT);
-	(*display).display();
+	Adafruit_GFX *canvas = beginFrame(display);
+	printAlignedText(canvas, caption, MS_FONT_TEXT_SIZE_LARGE, MS_V_CENTER | MS_H_CENTER);
+	submitDisplay(display);
 }
 
 void showActionPromptScreen(Adafruit_SSD1306 *display, char *btn, char *action)
 {
 	sprintf(stringPool20b1, "Press %s", btn);
 	char *message[] = {stringPool20b1, action};
-	GFXcanvas16 canvas(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&canvas);
-	printAlignedTextStack(&canvas, message, 2, DEFAULT_TEXT_SIZE, MS_H_CENTER, MS_H_CENTER | MS_V_CENTER);
-	(*display).drawRGBBitmap(0, 0, canvas.getBuffer(), SCREEN_WIDTH, SCREEN_HEIGHT);
-	(*display).display();
+	Adafruit_GFX *canvas = beginFrame(display);
+	printAlignedTextStack(canvas, message, 2, DEFAULT_TEXT_SIZE, MS_H_CENTER, MS_H_CENTER | MS_V_CENTER);
+	submitDisplay(display);
+}
+
+void showCalibrationProgressScreen(Adafruit_SSD1306 *display, const char *caption, int percent, uint32_t readings)
+{
+	sprintf(stringPool20b1, "%lu readings", (unsigned long)readings);
+	int barWidth = SCREEN_WIDTH - 20;
+	int barY = SCREEN_HEIGHT / 2 - 5;
+	Adafruit_GFX *canvas = beginFrame(display);
+	printAlignedText(canvas, caption, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_TOP);
+	(*canvas).drawRect(10, barY, barWidth, 10, SSD1306_WHITE);
+	(*canvas).fillRect(10, barY, barWidth * percent / 100, 10, SSD1306_WHITE);
+	printAlignedText(canvas, stringPool20b1, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
+	submitDisplay(display);
 }
 
 void drawSplashScreen(Adafruit_SSD1306 *display)
 {
 	sprintf(stringPool20b1, "Version: %s", MS_SYSTEM_VERSION);
 	char *texts[] = {"Irrigation", "System", stringPool20b1};
-	GFXcanvas16 canvas(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&canvas);
-	canvas.drawRoundRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 10, SSD1306_WHITE);
-	printAlignedTextStack(&canvas, texts, 3, DEFAULT_TEXT_SIZE, MS_H_CENTER, MS_H_CENTER | MS_V_CENTER);
-	(*display).drawRGBBitmap(0, 0, canvas.getBuffer(), SCREEN_WIDTH, SCREEN_HEIGHT);
-	(*display).display();
+	Adafruit_GFX *canvas = beginFrame(display);
+	(*canvas).drawRoundRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 10, SSD1306_WHITE);
+	printAlignedTextStack(canvas, texts, 3, DEFAULT_TEXT_SIZE, MS_H_CENTER, MS_H_CENTER | MS_V_CENTER);
+	submitDisplay(display);
 }
 
 // end of Display
 
+// Median of 9 reads, so a single spike (relay switching) cannot
+// pull the result the way it pulls a mean; target keeps its
+// value if any of the reads fails
 void extractMedianPinValueForProperty(int delayInterval, int *target, int sensorPin)
 {
-	int value = 0;
-	int iterations = 10;
+	uint16_t values[9];
 
-	for (int i = 0; i < iterations; i++)
+	for (int i = 0; i < 9; i++)
 	{
-		value += fixedAnalogRead(sensorPin);
+		int value;
+		if (!fixedAnalogRead(sensorPin, &value))
+		{
+			return;
+		}
+		values[i] = (uint16_t)value;
 		if (delayInterval > 0)
 		{
 			delay(delayInterval);
 		}
 	}
 
-	(*target) = (int)(value / iterations);
+	(*target) = ms_filter_median9(values);
 }
 
 // End of Helpers
@@ -667,80 +1050,42 @@ void extractMedianPinValueForProperty(int delayInterval, int *target, int sensor
 
 // Outlets
 
-bool canStartOutlet(Action *a)
-{
-	return availableActions[CLEAN_PUMP_ACTION].state != MS_RUNNING && availableActions[CALIBRATE_SENSOR_ACTION].state != MS_RUNNING;
-}
-
-// Far
-
-void startFarOutlet(Action *a)
-{
-	digitalWrite(PIN_VALVE_FAR, LOW);
-	state.vf = true;
-}
-
-void tickFarOutlet(Action *a)
-{
-}
-
-void stopFarOutlet(Action *a)
+// the zone of an outlet action
+int _outletZone(Action *a)
 {
-	digitalWrite(PIN_VALVE_FAR, HIGH);
-	state.vf = false;
+	return ZONES_COUNT - 1 - (int)(a - &availableActions[FIRST_OUTLET_ACTION]);
 }
 
-// end of Far
-
-// Mid
-
-void startMidOutlet(Action *a)
+void startOutlet(Action *a)
 {
-	digitalWrite(PIN_VALVE_MID, LOW);
-	state.vm = true;
+	int zone = _outletZone(a);
+	digitalWrite(zones[zone].valvePin, VALVE_PIN_HIGH);
+	(*state.z).v[zone] = true;
+	touchState();
 }
 
-void tickMidOutlet(Action *a)
+void tickOutlet(Action *a)
 {
 }
 
-void stopMidOutlet(Action *a)
+void stopOutlet(Action *a)
 {
-	digitalWrite(PIN_VALVE_MID, HIGH);
-	state.vm = false;
+	int zone = _outletZone(a);
+	digitalWrite(zones[zone].valvePin, VALVE_PIN_LOW);
+	(*state.z).v[zone] = false;
+	touchState();
 }
 
-// end of Mid
-
-// Near
-
-void startNearOutlet(Action *a)
-{
-	digitalWrite(PIN_VALVE_NEAR, LOW);
-	state.vn = true;
-}
-
-void tickNearOutlet(Action *a)
-{
-}
-
-void stopNearOutlet(Action *a)
-{
-	digitalWrite(PIN_VALVE_NEAR, HIGH);
-	state.vn = false;
-}
-
-// end of Near
-//
+// end of Outlets
 
 // wifi
 WebServer server(80);
 
 char *_resolveBLEStatusString(char *target)
 {
-	if (ble.isActive)
+	if (screenState.bleActive)
 	{
-		sprintf(target, "%d", ble.connectedPeers);
+		sprintf(target, "%d", screenState.peers);
 	}
 	else
 	{
@@ -787,6 +1132,7 @@ char *_resolveWiFIStatusString(char *target, int status)
 
 void updateWiFiStatus()
 {
+	int previous = wifi.state;
 	int status = WiFi.status();
 	switch (status)
 	{
@@ -818,6 +1164,11 @@ void updateWiFiStatus()
 		wifi.state = MS_WIFI_STOPPED;
 		break;
 	}
+
+	if (wifi.state != previous)
+	{
+		touchState();
+	}
 }
 
 bool _requestAuth()
@@ -832,8 +1183,8 @@ bool _requestAuth()
 
 unsigned long _calculateOnBeforeTime(unsigned long curTime, Action *a)
 {
-	int lastStopTime = (*a).lst;
-	int onBeforeTime = lastStopTime > 0 ? curTime - lastStopTime : 0;
+	unsigned long lastStopTime = (*a).lst;
+	unsigned long onBeforeTime = lastStopTime > 0 ? curTime - lastStopTime : 0;
 	return onBeforeTime;
 }
 
@@ -865,6 +1216,86 @@ void _getActionStateString(int state, char *target)
 	}
 }
 
+unsigned long _averageCallTime(const MSSchedTiming *t)
+{
+	return (*t).count > 0 ? (unsigned long)((*t).total / (*t).count) : 0;
+}
+
+// per action call latencies in us
+void _generateTimings(DynamicJsonDocument *doc)
+{
+	for (int i = 0; i < MS_SCHED_HISTOGRAM_BUCKETS - 1; i++)
+	{
+		(*doc)["timing"]["buckets_us"].add(ms_sched_histogram_bound(i));
+	}
+	(*doc)["timing"]["stop_bound_us"] = MS_SCHED_STOP_LATENCY_BOUND_US;
+
+	if (frameStats.frames > 0)
+	{
+		(*doc)["timing"]["ui"]["frames"] = frameStats.frames;
+		(*doc)["timing"]["ui"]["render_avg"] = (unsigned long)(frameStats.renderTotal / frameStats.frames);
+		(*doc)["timing"]["ui"]["render_max"] = frameStats.renderMax;
+		(*doc)["timing"]["ui"]["submit_avg"] = (unsigned long)(frameStats.submitTotal / frameStats.frames);
+		(*doc)["timing"]["ui"]["submit_max"] = frameStats.submitMax;
+		(*doc)["timing"]["ui"]["skipped"] = frameStats.skipped;
+		(*doc)["timing"]["ui"]["layout_hits"] = layoutCache.hits;
+		(*doc)["timing"]["ui"]["layout_misses"] = layoutCache.misses;
+	}
+
+	MSDisplayStats ds = displayStats();
+	if (ds.flushes > 0)
+	{
+		(*doc)["timing"]["display"]["flushes"] = ds.flushes;
+		(*doc)["timing"]["display"]["dropped"] = ds.dropped;
+		(*doc)["timing"]["display"]["flush_avg"] = (unsigned long)(ds.flushTotal / ds.flushes);
+		(*doc)["timing"]["display"]["flush_max"] = ds.flushMax;
+		(*doc)["timing"]["display"]["bytes_avg"] = (unsigned long)(ds.bytesTotal / ds.flushes);
+	}
+
+	for (int i = 0; i < ACTIONS_COUNT; i++)
+	{
+		Action *cur = &availableActions[i];
+		const MSSchedStats *st = ms_sched_stats(cur);
+		const MSSchedTiming *start = &(*st).phases[MS_SCHED_PHASE_START];
+		const MSSchedTiming *tick = &(*st).phases[MS_SCHED_PHASE_TICK];
+		const MSSchedTiming *stop = &(*st).phases[MS_SCHED_PHASE_STOP];
+
+		(*doc)["timing"][(*cur).name]["budget"] = (*st).budget;
+		(*doc)["timing"][(*cur).name]["overruns"] = (*st).overruns;
+		(*doc)["timing"][(*cur).name]["start_max"] = (*start).max;
+		(*doc)["timing"][(*cur).name]["stop_max"] = (*stop).max;
+		(*doc)["timing"][(*cur).name]["ticks"] = (*tick).count;
+		(*doc)["timing"][(*cur).name]["tick_avg"] = _averageCallTime(tick);
+		(*doc)["timing"][(*cur).name]["tick_max"] = (*tick).max;
+		for (int b = 0; b < MS_SCHED_HISTOGRAM_BUCKETS; b++)
+		{
+			(*doc)["timing"][(*cur).name]["tick_hist"].add((*tick).hist[b]);
+		}
+
+		if ((*st).yields > 0)
+		{
+			(*doc)["timing"][(*cur).name]["yields"] = (*st).yields;
+		}
+
+		if ((*st).busy > 0)
+		{
+			(*doc)["timing"][(*cur).name]["busy"] = (*st).busy;
+		}
+
+		if ((*st).demotions > 0)
+		{
+			(*doc)["timing"][(*cur).name]["demotions"] = (*st).demotions;
+			(*doc)["timing"][(*cur).name]["interval_us"] = (*st).interval;
+		}
+
+		if ((*stop).count > 0)
+		{
+			(*doc)["timing"][(*cur).name]["stop_latency_max"] = (*st).stopMax;
+			(*doc)["timing"][(*cur).name]["stops_late"] = (*st).stopLate;
+		}
+	}
+}
+
 void _generateStatus(DynamicJsonDocument *doc)
 {
 	(*doc)["status"] = "OK";
@@ -875,25 +1306,33 @@ void _generateStatus(DynamicJsonDocument *doc)
 	(*doc)["pump"]["iue"] = settings.iue;
 	(*doc)["sensors"]["di_sec"] = settings.sid / 1000;
 	(*doc)["sensors"]["p_di_sec"] = settings.siw / 1000;
+	(*doc)["sensors"]["cur_di_sec"] = availableActions[READ_SENSORS_ACTION].ti / 1000;
 	(*doc)["sensors"]["ontime_sec"] = availableActions[READ_SENSORS_ACTION].td / 1000;
 	(*doc)["sensors"]["on_before_mins"] = (int)(_calculateOnBeforeTime(time, &availableActions[READ_SENSORS_ACTION]) / 60000);
 
-	for (int i = 0; i < SENSORS_COUNT; i++)
+	MSZonesState *z = state.z;
+	for (int i = 0; i < ZONES_COUNT; i++)
 	{
-		Sensor *cur = &state.s[i];
-		bool isActive = (*cur).active;
-		(*doc)["sensors"][(*cur).name]["active"] = (*cur).active;
-		if (isActive)
+		const char *name = zones[i].name;
+		(*doc)["sensors"][name]["active"] = (*z).active[i];
+		if ((*z).active[i])
 		{
-			(*doc)["sensors"][(*cur).name]["hum_perc"] = (*cur).p;
-			(*doc)["sensors"][(*cur).name]["readings"]["dry_val"] = (*cur).dry;
-			(*doc)["sensors"][(*cur).name]["readings"]["wet_val"] = (*cur).wet;
-			(*doc)["sensors"][(*cur).name]["readings"]["cur_val"] = (*cur).value;
-			(*doc)["sensors"][(*cur).name]["on_before_mins"] = (int)(_calculateOnBeforeTime(time, &availableActions[(*cur).ai]) / 60000);
+			(*doc)["sensors"][name]["hum_perc"] = (*z).p[i];
+			(*doc)["sensors"][name]["hum_slope_ph"] = (*z).h[i].slope;
+			(*doc)["sensors"][name]["readings"]["dry_val"] = (*z).dry[i];
+			(*doc)["sensors"][name]["readings"]["wet_val"] = (*z).wet[i];
+			(*doc)["sensors"][name]["readings"]["cur_val"] = (*z).value[i];
+			(*doc)["sensors"][name]["readings"]["settle_ms"] = (*z).st[i].time;
+			int mv;
+			if (ms_adc_to_mv(zones[i].sensorPin, (*z).value[i], &mv))
+			{
+				(*doc)["sensors"][name]["readings"]["cur_mv"] = mv;
+			}
+			(*doc)["sensors"][name]["on_before_mins"] = (int)(_calculateOnBeforeTime(time, &availableActions[OUTLET_ACTION(i)]) / 60000);
 		}
 
-		(*doc)["sensors"][(*cur).name]["thresholds"]["apv"] = (*cur).apv;
-		(*doc)["sensors"][(*cur).name]["thresholds"]["dapv"] = (*cur).dapv;
+		(*doc)["sensors"][name]["thresholds"]["apv"] = (*z).apv[i];
+		(*doc)["sensors"][name]["thresholds"]["dapv"] = (*z).dapv[i];
 	}
 
 	for (int i = 0; i < ACTIONS_COUNT; i++)
@@ -902,96 +1341,159 @@ void _generateStatus(DynamicJsonDocument *doc)
 		_getActionStateString((*cur).state, stringPool20b1);
 		(*doc)["actions"][(*cur).name] = stringPool20b1;
 	}
+
+	_generateTimings(doc);
+}
+
+// Sends the document as the response. serializeJson silently truncates
+// what does not fit, so a document larger than the pool (or one which
+// ran out of memory while being filled) is answered with an error
+void _sendJson(DynamicJsonDocument *doc)
+{
+	size_t length = measureJson(*doc);
+	if ((*doc).overflowed() || length >= sizeof(stringPool4096b1))
+	{
+		ESP_LOGE("mothership", "Status does not fit: %u bytes", (unsigned)length);
+		server.send(500, "text/plain", "Status too large");
+		return;
+	}
+
+	serializeJson(*doc, stringPool4096b1, sizeof(stringPool4096b1));
+	server.send(200, "application/json", (char *)stringPool4096b1);
 }
 
 void handleStatus()
 {
 	_generateStatus(&doc1);
-	serializeJson(doc1, stringPool1024b1);
-	server.send(200, "application/json", (char *)stringPool1024b1);
+	_sendJson(&doc1);
 	doc1.clear();
-	memset(stringPool1024b1, 0, 1024);
+	memset(stringPool4096b1, 0, 4096);
 }
 
-void handleModifySetting()
+// Runs on the loop task, like every other change of the
+// settings, the zones state and the Action fields
+void _applySettingsEdit(MSSettingsEdit *edit)
 {
-	if (_requestAuth())
+	MSZonesState *z = state.z;
+	for (int i = 0; i < ZONES_COUNT; i++)
 	{
-
-		String body = server.arg("plain");
-		body.getBytes(stringPool1024b1, 1024, 0);
-		deserializeJson(doc1, stringPool1024b1);
-
-		if (doc1.containsKey(MS_APV_NEAR_SETTING_KEY))
+		if ((*edit).apv[i] != -1)
 		{
-			state.s[MS_SENSOR_NEAR].apv = max(0, (int)min((int)doc1[MS_APV_NEAR_SETTING_KEY], state.s[MS_SENSOR_NEAR].dapv - 5));
+			(*z).apv[i] = max(0, min((*edit).apv[i], (*z).dapv[i] - 5));
 		}
 
-		if (doc1.containsKey(MS_DAPV_NEAR_SETTING_KEY))
+		if ((*edit).dapv[i] != -1)
 		{
-			state.s[MS_SENSOR_NEAR].dapv = max(state.s[MS_SENSOR_NEAR].apv + 5, min((int)doc1[MS_DAPV_NEAR_SETTING_KEY], 100));
+			(*z).dapv[i] = max((*z).apv[i] + 5, min((*edit).dapv[i], 100));
 		}
 
-		if (doc1.containsKey(MS_APV_MID_SETTING_KEY))
+		if ((*edit).active[i] != -1)
 		{
-			state.s[MS_SENSOR_MID].apv = max(0, (int)min((int)doc1[MS_APV_MID_SETTING_KEY], state.s[MS_SENSOR_MID].dapv - 5));
+			(*z).active[i] = (*edit).active[i] == 1;
 		}
+	}
 
-		if (doc1.containsKey(MS_DAPV_MID_SETTING_KEY))
-		{
-			state.s[MS_SENSOR_MID].dapv = max(state.s[MS_SENSOR_MID].apv + 5, min((int)doc1[MS_DAPV_MID_SETTING_KEY], 100));
-		}
+	if ((*edit).pd != -1)
+	{
+		settings.pd = min(5L * 60000, max((*edit).pd, 60000L));
+	}
 
-		if (doc1.containsKey(MS_APV_FAR_SETTING_KEY))
-		{
-			state.s[MS_SENSOR_FAR].apv = max(0, (int)min((int)doc1[MS_APV_FAR_SETTING_KEY], state.s[MS_SENSOR_FAR].dapv - 5));
-		}
+	if ((*edit).pi != -1)
+	{
+		settings.pi = min(20L * 60000, max((*edit).pi, 60000L));
+	}
 
-		if (doc1.containsKey(MS_DAPV_FAR_SETTING_KEY))
-		{
-			state.s[MS_SENSOR_FAR].dapv = max(state.s[MS_SENSOR_FAR].apv + 5, min((int)doc1[MS_DAPV_FAR_SETTING_KEY], 100));
-		}
+	if ((*edit).iue != -1)
+	{
+		settings.iue = (*edit).iue == 1;
+	}
+	touchState();
 
-		if (doc1.containsKey(MS_PUMP_MAX_DURATION_SETTING_KEY))
-		{
-			settings.pd = min(5 * 60000, max((int)doc1[MS_PUMP_MAX_DURATION_SETTING_KEY], 60000));
-		}
+	storeSetPreferences();
+}
 
-		if (doc1.containsKey(MS_PUMP_REACT_INT_DURATION_SETTING_KEY))
-		{
-			settings.pi = min(20 * 60000, max((int)doc1[MS_PUMP_REACT_INT_DURATION_SETTING_KEY], 60000));
-		}
+void startApplySettings(Action *a)
+{
+}
 
-		if (doc1.containsKey(MS_NEAR_ACTIVE_SETTING_KEY))
-		{
-			state.s[MS_SENSOR_NEAR].active = (doc1[MS_NEAR_ACTIVE_SETTING_KEY] == true ? true : false);
-		}
+void stopApplySettings(Action *a)
+{
+}
+
+void tickApplySettings(Action *a)
+{
+	MSSettingsEdit edit;
+	bool applied = false;
+	while (xQueueReceive(settingsEdits.queue, &edit, 0) == pdTRUE)
+	{
+		_applySettingsEdit(&edit);
+		settingsEdits.appliedId = edit.id;
+		applied = true;
+	}
 
-		if (doc1.containsKey(MS_MID_ACTIVE_SETTING_KEY))
+	if (applied)
+	{
+		xSemaphoreGive(settingsEdits.applied);
+	}
+}
+
+void handleModifySetting()
+{
+	if (_requestAuth())
+	{
+
+		String body = server.arg("plain");
+		body.getBytes(stringPool1024b1, 1024, 0);
+		deserializeJson(doc1, stringPool1024b1);
+
+		MSSettingsEdit edit;
+		for (int i = 0; i < ZONES_COUNT; i++)
 		{
-			state.s[MS_SENSOR_MID].active = (doc1[MS_MID_ACTIVE_SETTING_KEY] == true ? true : false);
+			edit.apv[i] = doc1.containsKey(zones[i].apvKey) ? (int)doc1[zones[i].apvKey] : -1;
+			edit.dapv[i] = doc1.containsKey(zones[i].dapvKey) ? (int)doc1[zones[i].dapvKey] : -1;
+			edit.active[i] = doc1.containsKey(zones[i].activeKey) ? (doc1[zones[i].activeKey] == true ? 1 : 0) : -1;
 		}
+		edit.pd = doc1.containsKey(MS_PUMP_MAX_DURATION_SETTING_KEY) ? (long)doc1[MS_PUMP_MAX_DURATION_SETTING_KEY] : -1;
+		edit.pi = doc1.containsKey(MS_PUMP_REACT_INT_DURATION_SETTING_KEY) ? (long)doc1[MS_PUMP_REACT_INT_DURATION_SETTING_KEY] : -1;
+		edit.iue = doc1.containsKey(MS_IRRIGATE_UNTIL_EXPIRY_KEY) ? (doc1[MS_IRRIGATE_UNTIL_EXPIRY_KEY] == true ? 1 : 0) : -1;
 
-		if (doc1.containsKey(MS_FAR_ACTIVE_SETTING_KEY))
+		doc1.clear();
+		memset(stringPool1024b1, 0, 1024);
+
+		// the web server runs on the loop task when there is no worker
+		if (ms_sched_is_loop_task())
 		{
-			state.s[MS_SENSOR_FAR].active = (doc1[MS_FAR_ACTIVE_SETTING_KEY] == true ? true : false);
+			_applySettingsEdit(&edit);
 		}
-
-		if (doc1.containsKey(MS_IRRIGATE_UNTIL_EXPIRY_KEY))
+		else
 		{
-			settings.iue = doc1[MS_IRRIGATE_UNTIL_EXPIRY_KEY] == true ? true : false;
+			edit.id = ++settingsEdits.lastId;
+			if (xQueueSend(settingsEdits.queue, &edit, 0) != pdTRUE)
+			{
+				server.send(503, "text/plain", "Settings busy");
+				return;
+			}
+			ms_sched_trigger(&availableActions[APPLY_SETTINGS_ACTION], nullptr);
+
+			// the edit stays queued and is applied even if this times out
+			TickType_t start = xTaskGetTickCount();
+			TickType_t timeout = pdMS_TO_TICKS(MS_SETTINGS_APPLY_TIMEOUT_MS);
+			while ((int32_t)(settingsEdits.appliedId - edit.id) < 0)
+			{
+				TickType_t waited = xTaskGetTickCount() - start;
+				if (waited >= timeout || xSemaphoreTake(settingsEdits.applied, timeout - waited) != pdTRUE)
+				{
+					server.send(202, "text/plain", "Settings accepted");
+					return;
+				}
+			}
 		}
 
 		_generateStatus(&doc2);
-		serializeJson(doc2, stringPool1024b2);
-		server.send(200, "application/json", (char *)stringPool1024b2);
+		_sendJson(&doc2);
 
-		doc1.clear();
 		doc2.clear();
-		memset(stringPool1024b1, 0, 1024);
-		memset(stringPool1024b2, 0, 1024);
-
-		storeSetPreferences();
+		memset(stringPool4096b1, 0, 4096);
 	}
 }
 
@@ -1044,6 +1546,7 @@ void stopWifi(Action *a)
 	WiFi.disconnect();
 	WiFi.mode(WIFI_OFF);
 	wifi.state = MS_WIFI_STOPPED;
+	touchState();
 }
 
 // end of wifi
@@ -1058,124 +1561,230 @@ void stopInterpret(Action *a)
 {
 }
 
+// Time until the next sensors read while not watering. Each active
+// zone which is drying predicts when it will cross apv from its slope;
+// the earliest prediction (scaled by MS_SENSORS_PREDICTION_FRACTION)
+// decides, so reads get frequent as a zone nears its threshold. The
+// configured stand by interval stays the longest one, as without the
+// prediction.
+unsigned long _sensorsInterval(MSZonesState *z)
+{
+#ifdef MS_ADAPTIVE_SENSORS_INTERVAL
+	float interval = (float)settings.sid;
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		if (!(*z).active[i])
+		{
+			continue;
+		}
+
+		// no trend yet
+		if ((*z).h[i].count < MS_SENSORS_MIN_HISTORY)
+		{
+			return settings.sid;
+		}
+
+		if ((*z).p[i] <= (*z).apv[i])
+		{
+			return settings.siw;
+		}
+
+		// drying at slope percent per hour
+		float slope = (*z).h[i].slope;
+		if (slope < 0)
+		{
+			float predicted = ((*z).p[i] - (*z).apv[i]) / -slope * 3600000.0f;
+			interval = _min(interval, predicted * MS_SENSORS_PREDICTION_FRACTION);
+		}
+	}
+
+	return (unsigned long)_max(interval, (float)settings.siw);
+#else
+	return settings.sid;
+#endif
+}
+
 void tickInterpret(Action *a)
 {
+	// the readings handed over by the trigger
+	MSZonesState *z = (MSZonesState *)ms_sched_payload(a);
+	if (z == nullptr)
+	{
+		z = state.z;
+	}
+
 	bool activate = false;
-	Action **acandidates = (Action **)malloc(sizeof(Action *) * SENSORS_COUNT);
-	if (acandidates != nullptr)
+	uint32_t now = (uint32_t)(ms_sched_now() / 1000000);
+	Action *acandidates[ZONES_COUNT];
+	int mp[ZONES_COUNT];
+
+	ms_interpret_percents((*z).value, (*z).dry, (*z).wet, (*z).scale, mp, ZONES_COUNT);
+
+	int pc = 0;
+	int ac = 0;
+	for (int i = 0; i < ZONES_COUNT; i++)
 	{
-		int pc = 0;
-		int ac = 0;
-		for (int i = 0; i < SENSORS_COUNT; i++)
-		{
-			Sensor *se = &state.s[i];
-			Action *ca = &availableActions[(*se).ai];
-			float v = (float)(*se).value;
-			float d = (float)(*se).dry;
-			float w = (float)(*se).wet;
-			float dwd = _max(0.00001, d - w);
+		Action *ca = &availableActions[OUTLET_ACTION(i)];
 
-			float mp = ((d - _min(_max(v, w), d)) / dwd) * 100.0;
-			(*se).p = (int)mp;
+		ms_history_push(&(*z).h[i], now, (*z).value[i], mp[i]);
+		(*z).p[i] = (int)((*z).h[i].ema + 0.5f);
 
-			activate = (*se).active && (bool)((long)mp < ((*ca).state == MS_RUNNING ? (*se).dapv : (*se).apv));
+		// start on the smoothed percentage so a single dry reading does
+		// not open the outlet; stop on the latest one, the EMA lags
+		// behind a rising moisture and would keep the outlet open
+		if ((*ca).state == MS_RUNNING)
+		{
+			activate = (*z).active[i] && mp[i] < (*z).dapv[i];
+		}
+		else
+		{
+			activate = (*z).active[i] && (*z).p[i] < (*z).apv[i];
+		}
 
-			acandidates[i] = nullptr;
-			if (activate && ca != nullptr)
+		acandidates[i] = nullptr;
+		if (activate && ca != nullptr)
+		{
+			ac++;
+			if ((*ca).state == MS_NON_ACTIVE)
 			{
-				ac++;
-				if ((*ca).state == MS_NON_ACTIVE)
-				{
-					acandidates[i] = ca;
-					pc++;
-				}
-				else if ((*ca).state == MS_PENDING)
-				{
-					requestStop(&executionList, ca);
-				}
+				acandidates[i] = ca;
+				pc++;
 			}
-			else if (!settings.iue && ca != nullptr)
+			else if ((*ca).state == MS_PENDING)
 			{
-				// Stop the action for which activate is false
-				requestStop(&executionList, ca);
+				ms_sched_stop(ca);
 			}
 		}
+		else if (!settings.iue && ca != nullptr)
+		{
+			// Stop the action for which activate is false
+			ms_sched_stop(ca);
+		}
+	}
 
-		// if the available outlets are equal to the
-		// ones needed to be activated - we select the
-		// one that was activated the earliest
-		if (pc > 0 && pc == ac)
+	// if the available outlets are equal to the
+	// ones needed to be activated - we select the
+	// one that was activated the earliest
+	if (pc > 0 && pc == ac)
+	{
+
+		// in outlet action order, so ties go to the farthest zone
+		Action *ts = nullptr;
+		for (int i = ZONES_COUNT - 1; i >= 0; i--)
 		{
+			Action *c = acandidates[i];
 
-			Action *ts = nullptr;
-			for (int i = 0; i < SENSORS_COUNT; i++)
+			if (c != nullptr)
 			{
-				Action *c = acandidates[i];
-
-				if (c != nullptr)
+				if (ts != nullptr)
 				{
-					if (ts != nullptr)
-					{
-						if ((*c).st < (*ts).st)
-						{
-							ts = c;
-						}
-					}
-					else
+					if ((*c).st < (*ts).st)
 					{
 						ts = c;
 					}
 				}
-			}
-
-			if (ts != nullptr)
-			{
-				scheduleAction(&executionList, ts);
+				else
+				{
+					ts = c;
+				}
 			}
 		}
-		bool isPumpOpen = availableActions[PUMP_ACTION].state == MS_CHILD_RUNNING || availableActions[PUMP_ACTION].state == MS_CHILD_SCHEDULED;
-		availableActions[READ_SENSORS_ACTION].ti = isPumpOpen ? settings.siw : settings.sid;
 
-		free(acandidates);
+		if (ts != nullptr)
+		{
+			ms_sched_schedule(ts);
+		}
 	}
-}
-
-bool calibrateSensorCanStart(Action *a)
-{
-	return availableActions[READ_SENSORS_ACTION].state != MS_RUNNING && availableActions[PUMP_ACTION].state != MS_CHILD_RUNNING && availableActions[IRRIGATE_ACTION].state != MS_RUNNING;
+	bool isPumpOpen = availableActions[PUMP_ACTION].state == MS_CHILD_RUNNING || availableActions[PUMP_ACTION].state == MS_CHILD_SCHEDULED;
+	availableActions[READ_SENSORS_ACTION].ti = isPumpOpen ? settings.siw : _sensorsInterval(z);
+	ms_sched_touch(&availableActions[READ_SENSORS_ACTION]);
+	touchState();
 }
 
 void startCalibrateSensor(Action *a)
 {
 	digitalWrite(SENSOR_PIN, SENSOR_PIN_HIGH);
 	state.sa = true;
+	ms_calibration_reset(&sensorEditState.calibration);
+	ms_settle_reset(&sensorEditState.settle, ms_sched_now());
+	touchState();
+}
+
+// Takes one batch of readings of the zone being calibrated and keeps
+// the mean of all readings so far in target. The readings taken while
+// the sensor was settling after power on are dropped once it settles.
+void _calibrationBatch(int *target)
+{
+	int pin = zones[sensorEditState.sensorCode].sensorPin;
+	int values[MS_CALIBRATION_BATCH];
+	int count = 0;
+	int total = 0;
+
+	// failed reads are left out
+	for (int i = 0; i < MS_CALIBRATION_BATCH; i++)
+	{
+		if (fixedAnalogRead(pin, &values[count]))
+		{
+			total += values[count];
+			count++;
+		}
+	}
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	MSSettle *settle = &sensorEditState.settle;
+	if (!(*settle).settled && ms_settle_push(settle, total / count, ms_sched_now()))
+	{
+		ms_calibration_reset(&sensorEditState.calibration);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		ms_calibration_push(&sensorEditState.calibration, values[i]);
+	}
+
+	(*target) = ms_calibration_mean(&sensorEditState.calibration);
+}
+
+void _calibrationReport(const char *type)
+{
+	MSCalibration *c = &sensorEditState.calibration;
+	ESP_LOGI("mothership", "Calibrated %s %s: %d, spread %d (%d-%d), %lu readings, settled in %lums",
+			 zones[sensorEditState.sensorCode].name, type, ms_calibration_mean(c), ms_calibration_spread(c),
+			 (*c).min, (*c).max, (unsigned long)(*c).count, (unsigned long)sensorEditState.settle.time);
 }
 
 void tickCalibrateSensor(Action *a)
 {
-	int startTime = (*a).st;
-	int currentTime = millis();
+	unsigned long startTime = (*a).st;
+	unsigned long currentTime = millis();
+	int zone = sensorEditState.sensorCode;
 
 	switch (sensorEditState.state)
 	{
 	case MS_SENSOR_CALIBRATION_READ_DRY_STATE:
-		if (currentTime - startTime < 10000)
+		if (currentTime - startTime < MS_SENSOR_CALIBRATION_READ_MS)
 		{
-			extractMedianPinValueForProperty(1, &state.s[sensorEditState.sensorCode].dry, sensorEditState.pin);
+			_calibrationBatch(&(*state.z).dry[zone]);
 		}
 		else
 		{
+			_calibrationReport("dry");
 			sensorEditState.state = MS_SENSOR_CALIBRATION_INITIAL_WET_STATE;
-			requestStop(&executionList, a);
+			ms_sched_stop(a);
 		}
 		break;
 	case MS_SENSOR_CALIBRATION_READ_WET_STATE:
-		if (currentTime - startTime < 10000)
+		if (currentTime - startTime < MS_SENSOR_CALIBRATION_READ_MS)
 		{
-			extractMedianPinValueForProperty(0, &state.s[sensorEditState.sensorCode].wet, sensorEditState.pin);
+			_calibrationBatch(&(*state.z).wet[zone]);
 		}
 		else
 		{
+			_calibrationReport("wet");
 			sensorEditState.state = MS_SENSOR_CALIBRATION_STORE_VALUES_STATE;
 		}
 		break;
@@ -1183,72 +1792,196 @@ void tickCalibrateSensor(Action *a)
 	case MS_SENSOR_CALIBRATION_STORE_VALUES_STATE:
 	{
 		preferences.begin(MS_PREFERENCES_ID, false);
-		preferences.putInt(MS_NEAR_DRY_SETTING_KEY, state.s[MS_SENSOR_NEAR].dry);
-		preferences.putInt(MS_MID_DRY_SETTING_KEY, state.s[MS_SENSOR_MID].dry);
-		preferences.putInt(MS_FAR_DRY_SETTING_KEY, state.s[MS_SENSOR_FAR].dry);
-		preferences.putInt(MS_NEAR_WET_SETTING_KEY, state.s[MS_SENSOR_NEAR].wet);
-		preferences.putInt(MS_MID_WET_SETTING_KEY, state.s[MS_SENSOR_MID].wet);
-		preferences.putInt(MS_FAR_WET_SETTING_KEY, state.s[MS_SENSOR_FAR].wet);
+		preferences.putInt(zones[zone].dryKey, (*state.z).dry[zone]);
+		preferences.putInt(zones[zone].wetKey, (*state.z).wet[zone]);
 		preferences.end();
+		(*state.z).scale[zone] = ms_interpret_scale((*state.z).dry[zone], (*state.z).wet[zone]);
+		// the percentages in the history are relative to the old calibration
+		ms_history_reset(&(*state.z).h[zone]);
 		sensorEditState.state = MS_SENSOR_CALIBRATION_FINAL_STATE;
-		requestStop(&executionList, a);
+		ms_sched_stop(a);
 	}
 	break;
 	}
+
+	// the readings so far or the next step are shown on the calibration screen
+	touchState();
 }
 
 void stopCalibrateSensor(Action *a)
 {
 	digitalWrite(SENSOR_PIN, SENSOR_PIN_LOW);
 	state.sa = false;
-}
-
-bool readSensorsCanStart(Action *a)
-{
-	return availableActions[CALIBRATE_SENSOR_ACTION].state != MS_RUNNING && availableActions[IRRIGATE_ACTION].state != MS_RUNNING && availableActions[CLEAN_PUMP_ACTION].state != MS_RUNNING;
+	touchState();
 }
 
 void startSensors(Action *a)
 {
 	digitalWrite(SENSOR_PIN, SENSOR_PIN_HIGH);
 	state.sa = true;
+	ms_adc_start();
+	touchState();
+
+	MSSchedTime now = ms_sched_now();
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		ms_settle_reset(&(*state.z).st[i], now);
+	}
+	sensorsReadings = 0;
+}
+
+void stopSensors(Action *a)
+{
+	ms_adc_stop();
+	digitalWrite(SENSOR_PIN, SENSOR_PIN_LOW);
+	state.sa = false;
+	touchState();
+	// interpret the fresh readings and open the outlets in this same cycle
+	ms_sched_trigger(&availableActions[INTERPRET_SENSOR_DATA_ACTION], state.z);
+}
+
+void tickSensors(Action *a)
+{
+	MSZonesState *z = state.z;
+
+	// reduce what the sampler collected since the last tick
+	bool sampled = ms_adc_running();
+	if (sampled)
+	{
+		ms_adc_collect();
+	}
+
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		if (sampled)
+		{
+			ms_adc_filtered(zones[i].sensorPin, &(*z).value[i]);
+		}
+		else
+		{
+			extractMedianPinValueForProperty(0, &(*z).value[i], zones[i].sensorPin);
+		}
+	}
+
+	// power the sensors off as soon as all active ones
+	// have settled instead of for the whole td
+	MSSchedTime now = ms_sched_now();
+	bool settled = ++sensorsReadings >= MS_SENSORS_MIN_READINGS;
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		if ((*z).active[i] && !ms_settle_push(&(*z).st[i], (*z).value[i], now))
+		{
+			settled = false;
+		}
+	}
+
+	// end this read only; the next one is still due ti later
+	if (settled)
+	{
+		ms_sched_end(a);
+	}
+}
+
+// end of sensors
+
+// Display
+
+const char *_hsResolveSensorInfo(char *target, int zone)
+{
+	if (screenState.active[zone])
+	{
+		sprintf(target, "%d%%", screenState.zp[zone]);
+	}
+	else
+	{
+		return MS_OFF_STRING;
+	}
+	return target;
+}
+
+// Home screen lines of the zones on the current home page
+void _hsResolveZonesInfo(char *sensors, char *valves)
+{
+	int pages = (ZONES_COUNT + MS_HOME_PAGE_SIZE - 1) / MS_HOME_PAGE_SIZE;
+	int first = (int)((millis() / MS_HOME_PAGE_MS) % pages) * MS_HOME_PAGE_SIZE;
+
+	sensors[0] = '\0';
+	valves[0] = '\0';
+	for (int i = first; i < first + MS_HOME_PAGE_SIZE && i < ZONES_COUNT; i++)
+	{
+		const char *separator = i > first ? " " : "";
+		sprintf(stringPool10b2, "%s%s: %s", separator, zones[i].label, _hsResolveSensorInfo(stringPool5b1, i));
+		strcat(sensors, stringPool10b2);
+		sprintf(stringPool10b2, "%sV%s: %s", separator, zones[i].label, screenState.v[i] ? MS_ON_STRING : MS_OFF_STRING);
+		strcat(valves, stringPool10b2);
+	}
 }
 
-void stopSensors(Action *a)
+// Zones on a page of the zone pickers
+int _pickerPageSize()
 {
-	digitalWrite(SENSOR_PIN, SENSOR_PIN_LOW);
-	state.sa = false;
-	scheduleAction(&executionList, &availableActions[INTERPRET_SENSOR_DATA_ACTION]);
+	return ZONES_COUNT > MS_PICKER_BUTTONS ? MS_PICKER_BUTTONS - 1 : MS_PICKER_BUTTONS;
 }
 
-void tickSensors(Action *a)
+// Lines of the current picker page
+int _pickerText(char **text)
 {
-	extractMedianPinValueForProperty(0, &state.s[MS_SENSOR_NEAR].value, PIN_NEAR);
-	extractMedianPinValueForProperty(0, &state.s[MS_SENSOR_MID].value, PIN_MID);
-	extractMedianPinValueForProperty(0, &state.s[MS_SENSOR_FAR].value, PIN_FAR);
-}
+	char *pool[] = {stringPool20b1, stringPool20b2, stringPool20b3};
+	int size = _pickerPageSize();
+	int first = screenState.page * size;
+	int count = 0;
 
-// end of sensors
+	for (int i = first; i < first + size && i < ZONES_COUNT; i++)
+	{
+		sprintf(pool[count], "B%d - %s", count + 2, zones[i].name);
+		text[count] = pool[count];
+		count++;
+	}
 
-// Display
+	if (size < MS_PICKER_BUTTONS)
+	{
+		text[count++] = "B4 - More";
+	}
+
+	return count;
+}
 
-const char *_hsResolveSensorInfo(char *target, Sensor *s)
+// Zone picked with B2-B4, -1 if none
+int _pickerZone(int buttonValue)
 {
-	if ((*s).active)
+	int slot = -1;
+	if (buttonValue > BUTTON_2_LOW && buttonValue < BUTTON_2_HIGH)
 	{
-		sprintf(target, "%d%%", (*s).p);
+		slot = 0;
 	}
-	else
+	else if (buttonValue > BUTTON_3_LOW && buttonValue < BUTTON_3_HIGH)
 	{
-		return MS_OFF_STRING;
+		slot = 1;
 	}
-	return target;
+	else if (buttonValue > BUTTON_4_LOW && buttonValue < BUTTON_4_HIGH)
+	{
+		slot = 2;
+	}
+
+	int size = _pickerPageSize();
+	if (slot == -1)
+	{
+		return -1;
+	}
+	else if (slot >= size)
+	{
+		int pages = (ZONES_COUNT + size - 1) / size;
+		sensorEditState.page = (sensorEditState.page + 1) % pages;
+		return -1;
+	}
+
+	int zone = sensorEditState.page * size + slot;
+	return zone < ZONES_COUNT ? zone : -1;
 }
 
 void drawEmptyScreen(Action *a)
 {
 	display.clearDisplay();
-	display.display();
 }
 
 void handleEmptyScreen(int buttonValue)
@@ -1261,17 +1994,13 @@ void handleEmptyScreen(int buttonValue)
 
 void drawHomeScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
-	sprintf(stringPool30b1, "N: %s M: %s F: %s", _hsResolveSensorInfo(stringPool5b1, &state.s[MS_SENSOR_NEAR]), _hsResolveSensorInfo(stringPool5b2, &state.s[MS_SENSOR_MID]), _hsResolveSensorInfo(stringPool5b3, &state.s[MS_SENSOR_FAR]));
-	sprintf(stringPool30b2, "VN: %s VM: %s VF: %s", state.vn ? MS_ON_STRING : MS_OFF_STRING, state.vm ? MS_ON_STRING : MS_OFF_STRING, state.vf ? MS_ON_STRING : MS_OFF_STRING);
-	sprintf(stringPool30b3, "PUMP: %s SENSORS: %s", state.p ? MS_ON_STRING : MS_OFF_STRING, state.sa ? MS_ON_STRING : MS_OFF_STRING);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
+	_hsResolveZonesInfo(stringPool30b1, stringPool30b2);
+	sprintf(stringPool30b3, "PUMP: %s SENSORS: %s", screenState.p ? MS_ON_STRING : MS_OFF_STRING, screenState.sa ? MS_ON_STRING : MS_OFF_STRING);
 	sprintf(stringPool30b4, "WIFI: %s BLE: %s", _resolveWiFIStatusString(stringPool20b2, wifi.state), _resolveBLEStatusString(stringPool10b1));
 	char *message[] = {stringPool30b1, stringPool30b2, stringPool30b3, stringPool30b4};
-	printAlignedTextStack(&mainCanvas, message, 4, 1, MS_H_CENTER, MS_H_CENTER | MS_V_TOP);
-	printAlignedText(&mainCanvas, "B1 - menu, B2 - dim", 1, (MS_H_CENTER | MS_V_BOTTOM));
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedTextStack(mainCanvas, message, 4, 1, MS_H_CENTER, MS_H_CENTER | MS_V_TOP);
+	printAlignedText(mainCanvas, "B1 - menu, B2 - dim", 1, (MS_H_CENTER | MS_V_BOTTOM));
 }
 
 void handleHomeScreen(int buttonValue)
@@ -1288,13 +2017,11 @@ void handleHomeScreen(int buttonValue)
 
 void drawThresholdsSettingsMenuScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
-	char *text[] = {"B2 - Edit NEAR", "B3 - Edit MID", "B4 - Edit FAR"};
-	printAlignedTextStack(&mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
-	printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
+	char *text[MS_PICKER_BUTTONS];
+	int lines = _pickerText(text);
+	printAlignedTextStack(mainCanvas, text, lines, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+	printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleThresholdsSettingsMenuScreen(int buttonValue)
@@ -1304,59 +2031,51 @@ void handleThresholdsSettingsMenuScreen(int buttonValue)
 	{
 		state.scr = MS_SETTINGS_SCREEN;
 		sensorEditState.sensorCode = -1;
+		sensorEditState.page = 0;
+		return;
 	}
-	else if (buttonValue > BUTTON_2_LOW && buttonValue < BUTTON_2_HIGH)
-	{
-		sensorEditState.sensorCode = MS_SENSOR_NEAR;
-		state.scr = MS_THRESHOLDS_SETTINGS_SCREEN;
-	}
-	else if (buttonValue > BUTTON_3_LOW && buttonValue < BUTTON_3_HIGH)
-	{
-		sensorEditState.sensorCode = MS_SENSOR_MID;
-		state.scr = MS_THRESHOLDS_SETTINGS_SCREEN;
-	}
-	else if (buttonValue > BUTTON_4_LOW && buttonValue < BUTTON_4_HIGH)
+
+	int zone = _pickerZone(buttonValue);
+	if (zone != -1)
 	{
-		sensorEditState.sensorCode = MS_SENSOR_FAR;
+		sensorEditState.sensorCode = zone;
 		state.scr = MS_THRESHOLDS_SETTINGS_SCREEN;
 	}
 }
 
 void drawThresholdsSettingsScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
 
-	Sensor *current = &state.s[sensorEditState.sensorCode];
+	int zone = screenState.zone;
 
-	sprintf(stringPool20b3, "Editing: %s", (*current).name);
-	sprintf(stringPool20b1, "APV: %d%%", (*current).apv);
-	sprintf(stringPool20b2, "DAPV: %d%%", (*current).dapv);
+	sprintf(stringPool20b3, "Editing: %s", zones[zone].name);
+	sprintf(stringPool20b1, "APV: %d%%", screenState.apv[zone]);
+	sprintf(stringPool20b2, "DAPV: %d%%", screenState.dapv[zone]);
 	char *message[] = {stringPool20b3, stringPool20b1, stringPool20b2};
-	printAlignedTextStack(&mainCanvas, message, 3, MS_FONT_TEXT_SIZE_LARGE, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+	printAlignedTextStack(mainCanvas, message, 3, MS_FONT_TEXT_SIZE_LARGE, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
 
-	printAlignedText(&mainCanvas, "B1 - Back, B2-B3 - edit", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedText(mainCanvas, "B1 - Back, B2-B3 - edit", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleThresholdsSettingsScreen(int buttonValue)
 {
-	Sensor *current = &state.s[sensorEditState.sensorCode];
+	int *apv = &(*state.z).apv[sensorEditState.sensorCode];
+	int *dapv = &(*state.z).dapv[sensorEditState.sensorCode];
 	if (buttonValue > BUTTON_1_LOW && buttonValue < BUTTON_1_HIGH)
 	{
 		state.scr = MS_THRESHOLDS_SETTINGS_MENU_SCREEN;
 	}
 	else if (buttonValue > BUTTON_2_LOW && buttonValue < BUTTON_2_HIGH)
 	{
-		int upperLimit = _max((*current).dapv - 5, 0);
- 		int nv = _min(((*current).apv + 5) % _max((*current).dapv, 5), upperLimit);
-		(*current).apv = nv;
+		int upperLimit = _max((*dapv) - 5, 0);
+ 		int nv = _min(((*apv) + 5) % _max((*dapv), 5), upperLimit);
+		(*apv) = nv;
 	}
 	else if (buttonValue > BUTTON_3_LOW && buttonValue < BUTTON_3_HIGH)
 	{
-		int nv = _max(_min(((*current).dapv + 5) % 105, 100), _min((*current).apv + 5, 100));
-		(*current).dapv = nv;
+		int nv = _max(_min(((*dapv) + 5) % 105, 100), _min((*apv) + 5, 100));
+		(*dapv) = nv;
 	}
 
 	storeSetPreferences();
@@ -1364,50 +2083,47 @@ void handleThresholdsSettingsScreen(int buttonValue)
 
 void drawCalibrationInfoScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
-	Sensor *s = &state.s[sensorEditState.sensorCode];
-	switch (sensorEditState.state)
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
+	int zone = screenState.zone;
+	switch (screenState.calibration)
 	{
 	case MS_SENSOR_CALIBRATION_INITIAL_DRY_STATE:
 	{
 		char *message1[] = {"Press B2", "to read", "DRY value"};
-		printAlignedTextStack(&mainCanvas, message1, 3, MS_FONT_TEXT_SIZE_LARGE, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
-		printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
+		printAlignedTextStack(mainCanvas, message1, 3, MS_FONT_TEXT_SIZE_LARGE, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+		printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 	}
 	break;
 	case MS_SENSOR_CALIBRATION_READ_DRY_STATE:
 	{
-		sprintf(stringPool20b2, "Sensor: %s", (*s).name);
-		sprintf(stringPool20b3, "Value: %d", (*s).dry);
+		sprintf(stringPool20b2, "Sensor: %s", zones[zone].name);
+		sprintf(stringPool20b3, "Value: %d+-%d", screenState.dry[zone], screenState.spread);
 		char *message2[] = {stringPool20b2, "Type: DRY", stringPool20b3};
-		printAlignedTextStack(&mainCanvas, message2, 3, MS_FONT_TEXT_SIZE_LARGE, MS_H_LEFT, MS_H_CENTER | MS_V_CENTER);
+		printAlignedTextStack(mainCanvas, message2, 3, MS_FONT_TEXT_SIZE_LARGE, MS_H_LEFT, MS_H_CENTER | MS_V_CENTER);
 	}
 	break;
 	case MS_SENSOR_CALIBRATION_INITIAL_WET_STATE:
 	{
 		char *message3[] = {"Press B2", "to read", "WET value"};
-		printAlignedTextStack(&mainCanvas, message3, 3, MS_FONT_TEXT_SIZE_LARGE, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
-		printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
+		printAlignedTextStack(mainCanvas, message3, 3, MS_FONT_TEXT_SIZE_LARGE, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+		printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 	}
 	break;
 	case MS_SENSOR_CALIBRATION_READ_WET_STATE:
 	{
-		sprintf(stringPool20b2, "Sensor: %s", (*s).name);
-		sprintf(stringPool20b3, "Value: %d", (*s).wet);
+		sprintf(stringPool20b2, "Sensor: %s", zones[zone].name);
+		sprintf(stringPool20b3, "Value: %d+-%d", screenState.wet[zone], screenState.spread);
 		char *message4[] = {stringPool20b2, "Type: WET", stringPool20b3};
-		printAlignedTextStack(&mainCanvas, message4, 3, MS_FONT_TEXT_SIZE_LARGE, MS_H_LEFT, MS_H_CENTER | MS_V_CENTER);
+		printAlignedTextStack(mainCanvas, message4, 3, MS_FONT_TEXT_SIZE_LARGE, MS_H_LEFT, MS_H_CENTER | MS_V_CENTER);
 	}
 	break;
 	case MS_SENSOR_CALIBRATION_FINAL_STATE:
 	{
 		char *message5[] = {"Press B1", "to exit"};
-		printAlignedTextStack(&mainCanvas, message5, 2, MS_FONT_TEXT_SIZE_LARGE, MS_H_LEFT, MS_H_CENTER | MS_V_CENTER);
+		printAlignedTextStack(mainCanvas, message5, 2, MS_FONT_TEXT_SIZE_LARGE, MS_H_LEFT, MS_H_CENTER | MS_V_CENTER);
 	}
 	break;
 	}
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
 }
 
 void handleCalibrationInfoScreen(int buttonValue)
@@ -1418,7 +2134,7 @@ void handleCalibrationInfoScreen(int buttonValue)
 		if (buttonValue > BUTTON_2_LOW && buttonValue < BUTTON_2_HIGH)
 		{
 			sensorEditState.state = MS_SENSOR_CALIBRATION_READ_DRY_STATE;
-			scheduleAction(&executionList, &availableActions[CALIBRATE_SENSOR_ACTION]);
+			ms_sched_schedule(&availableActions[CALIBRATE_SENSOR_ACTION]);
 		}
 		else if (buttonValue > BUTTON_1_LOW && buttonValue < BUTTON_1_HIGH)
 		{
@@ -1431,7 +2147,7 @@ void handleCalibrationInfoScreen(int buttonValue)
 		if (buttonValue > BUTTON_2_LOW && buttonValue < BUTTON_2_HIGH)
 		{
 			sensorEditState.state = MS_SENSOR_CALIBRATION_READ_WET_STATE;
-			scheduleAction(&executionList, &availableActions[CALIBRATE_SENSOR_ACTION]);
+			ms_sched_schedule(&availableActions[CALIBRATE_SENSOR_ACTION]);
 		}
 		else if (buttonValue > BUTTON_1_LOW && buttonValue < BUTTON_1_HIGH)
 		{
@@ -1450,20 +2166,18 @@ void handleCalibrationInfoScreen(int buttonValue)
 
 void drawSensorSettingsCalibrationScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
-	if (availableActions[CALIBRATE_SENSOR_ACTION].canStart(nullptr))
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
+	if (screenState.canCalibrate)
 	{
-		char *text[] = {"B2 - Near", "B3 - Mid", "B4 - Far"};
-		printAlignedTextStack(&mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+		char *text[MS_PICKER_BUTTONS];
+		int lines = _pickerText(text);
+		printAlignedTextStack(mainCanvas, text, lines, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
 	}
 	else
 	{
-		printAlignedText(&mainCanvas, "Cannot Start", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_CENTER);
+		printAlignedText(mainCanvas, "Cannot Start", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_CENTER);
 	}
-	printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleSensorSettingsCalibrationScreen(int buttonValue)
@@ -1472,25 +2186,14 @@ void handleSensorSettingsCalibrationScreen(int buttonValue)
 	{
 		state.scr = MS_SENSOR_SETTINGS_MENU_SCREEN;
 		sensorEditState.sensorCode = -1;
+		sensorEditState.page = 0;
+		return;
 	}
-	else if (buttonValue > BUTTON_2_LOW && buttonValue < BUTTON_2_HIGH)
-	{
-		sensorEditState.sensorCode = MS_SENSOR_NEAR;
-		sensorEditState.pin = PIN_NEAR;
-		sensorEditState.state = MS_SENSOR_CALIBRATION_INITIAL_DRY_STATE;
-		state.scr = MS_CALIBRATION_INFO_SCREEN;
-	}
-	else if (buttonValue > BUTTON_3_LOW && buttonValue < BUTTON_3_HIGH)
-	{
-		sensorEditState.sensorCode = MS_SENSOR_MID;
-		sensorEditState.pin = PIN_MID;
-		sensorEditState.state = MS_SENSOR_CALIBRATION_INITIAL_DRY_STATE;
-		state.scr = MS_CALIBRATION_INFO_SCREEN;
-	}
-	else if (buttonValue > BUTTON_4_LOW && buttonValue < BUTTON_4_HIGH)
+
+	int zone = _pickerZone(buttonValue);
+	if (zone != -1)
 	{
-		sensorEditState.sensorCode = MS_SENSOR_FAR;
-		sensorEditState.pin = PIN_FAR;
+		sensorEditState.sensorCode = zone;
 		sensorEditState.state = MS_SENSOR_CALIBRATION_INITIAL_DRY_STATE;
 		state.scr = MS_CALIBRATION_INFO_SCREEN;
 	}
@@ -1498,13 +2201,10 @@ void handleSensorSettingsCalibrationScreen(int buttonValue)
 
 void drawSensorSettingsMenuScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
 	char *text[] = {"B2 - Turn On/Off", "B3 - Calibrate", "B4 - Intervals"};
-	printAlignedTextStack(&mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
-	printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedTextStack(mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+	printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleSensorSettingsMenuScreen(int buttonValue)
@@ -1516,71 +2216,68 @@ void handleSensorSettingsMenuScreen(int buttonValue)
 	}
 	else if (buttonValue > BUTTON_2_LOW && buttonValue < BUTTON_2_HIGH)
 	{
-		sensorEditState.sensorCode = MS_SENSOR_NEAR;
+		sensorEditState.page = 0;
 		state.scr = MS_SENSOR_POWER_SETTINGS_SCREEN;
 	}
 	else if (buttonValue > BUTTON_3_LOW && buttonValue < BUTTON_3_HIGH)
 	{
-		sensorEditState.sensorCode = MS_SENSOR_MID;
+		sensorEditState.page = 0;
 		state.scr = MS_SENSOR_CALIBRATION_SETTINGS_SCREEN;
 	}
 	else if (buttonValue > BUTTON_4_LOW && buttonValue < BUTTON_4_HIGH)
 	{
-		sensorEditState.sensorCode = MS_SENSOR_MID;
 		state.scr = MS_SENSOR_INTERVALS_SETTINGS_SCREEN;
 	}
 }
 
 void drawSensorSettingsScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
 	int circleRadius = 17;
 	int spacing = 3;
-	int boxWidth = 2 * spacing + 3 * (circleRadius * 2);
+	int size = _pickerPageSize();
+	int first = screenState.page * size;
+	int count = _min(size, ZONES_COUNT - first);
+	int boxWidth = (count - 1) * spacing + count * (circleRadius * 2);
 	int boxX = SCREEN_WIDTH / 2 - boxWidth / 2 + circleRadius;
 	int boxY = circleRadius;
 
-	for (int i = 0; i < SENSORS_COUNT; i++)
+	for (int i = first; i < first + count; i++)
 	{
-		Sensor *s = &state.s[i];
-		bool isActive = (*s).active;
-		if ((*s).active)
+		bool isActive = screenState.active[i];
+		if (isActive)
 		{
-			mainCanvas.fillCircle(boxX, boxY, circleRadius, SSD1306_WHITE);
+			(*mainCanvas).fillCircle(boxX, boxY, circleRadius, SSD1306_WHITE);
 		}
 		else
 		{
 
-			mainCanvas.drawCircle(boxX, boxY, circleRadius, SSD1306_WHITE);
+			(*mainCanvas).drawCircle(boxX, boxY, circleRadius, SSD1306_WHITE);
 		}
-		int16_t x, y;
 		uint16_t w, h;
-		sprintf(stringPool10b1, "%d%%", (*s).p);
-		mainCanvas.getTextBounds(isActive ? stringPool10b1 : MS_OFF_STRING, 0, 0, &x, &y, &w, &h);
-		mainCanvas.setCursor(boxX - w / 2 + w % 2, boxY - h / 2 + h % 2 + FONT_BASELINE_CORRECTION_NORMAL / 2);
-		mainCanvas.setTextColor(isActive ? SSD1306_BLACK : SSD1306_WHITE);
-		mainCanvas.setTextSize(MS_FONT_TEXT_SIZE_NORMAL);
+		sprintf(stringPool10b1, "%d%%", screenState.zp[i]);
+		_textBounds(mainCanvas, isActive ? stringPool10b1 : MS_OFF_STRING, MS_FONT_TEXT_SIZE_NORMAL, &w, &h);
+		(*mainCanvas).setCursor(boxX - w / 2 + w % 2, boxY - h / 2 + h % 2 + FONT_BASELINE_CORRECTION_NORMAL / 2);
+		(*mainCanvas).setTextColor(isActive ? SSD1306_BLACK : SSD1306_WHITE);
+		(*mainCanvas).setTextSize(MS_FONT_TEXT_SIZE_NORMAL);
 
 		if (isActive)
 		{
-			mainCanvas.print(stringPool10b1);
+			(*mainCanvas).print(stringPool10b1);
 		}
 		else
 		{
-			mainCanvas.print(MS_OFF_STRING);
+			(*mainCanvas).print(MS_OFF_STRING);
 		}
 
-		mainCanvas.getTextBounds((*s).name, 0, 0, &x, &y, &w, &h);
-		mainCanvas.setTextColor(SSD1306_WHITE);
-		printPositionedText(&mainCanvas, (*s).name, boxX - w / 2, boxY + circleRadius + spacing + FONT_BASELINE_CORRECTION_NORMAL);
+		_textBounds(mainCanvas, zones[i].name, MS_FONT_TEXT_SIZE_NORMAL, &w, &h);
+		(*mainCanvas).setTextColor(SSD1306_WHITE);
+		printPositionedText(mainCanvas, zones[i].name, boxX - w / 2, boxY + circleRadius + spacing + FONT_BASELINE_CORRECTION_NORMAL);
 
 		boxX += circleRadius * 2 + spacing;
 	}
 
-	printAlignedText(&mainCanvas, "B1 - Back, B2-B4 - edit", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedText(mainCanvas, size < MS_PICKER_BUTTONS ? "B1 - Back, B2-B3 - edit, B4 - more" : "B1 - Back, B2-B4 - edit", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleSensorSettingsScreen(int buttonValue)
@@ -1588,42 +2285,26 @@ void handleSensorSettingsScreen(int buttonValue)
 	if (buttonValue > BUTTON_1_LOW && buttonValue < BUTTON_1_HIGH)
 	{
 		state.scr = MS_SENSOR_SETTINGS_MENU_SCREEN;
+		sensorEditState.page = 0;
+		return;
 	}
-	else if (buttonValue > BUTTON_2_LOW && buttonValue < BUTTON_2_HIGH)
-	{
-		bool isActive = state.s[MS_SENSOR_FAR].active = !state.s[MS_SENSOR_FAR].active;
-		if (!isActive)
-		{
-			availableActions[OUTLET_MID_ACTION].lst = 0;
-			availableActions[OUTLET_MID_ACTION].st = 0;
-		}
-	}
-	else if (buttonValue > BUTTON_3_LOW && buttonValue < BUTTON_3_HIGH)
-	{
-		bool isActive = state.s[MS_SENSOR_MID].active = !state.s[MS_SENSOR_MID].active;
-		if (!isActive)
-		{
-			availableActions[OUTLET_MID_ACTION].lst = 0;
-			availableActions[OUTLET_MID_ACTION].st = 0;
-		}
-	}
-	else if (buttonValue > BUTTON_4_LOW && buttonValue < BUTTON_4_HIGH)
+
+	int zone = _pickerZone(buttonValue);
+	if (zone != -1)
 	{
-		bool isActive = state.s[MS_SENSOR_NEAR].active = !state.s[MS_SENSOR_NEAR].active;
+		bool isActive = (*state.z).active[zone] = !(*state.z).active[zone];
 		if (!isActive)
 		{
-			availableActions[OUTLET_NEAR_ACTION].lst = 0;
-			availableActions[OUTLET_NEAR_ACTION].st = 0;
+			availableActions[OUTLET_ACTION(zone)].lst = 0;
+			availableActions[OUTLET_ACTION(zone)].st = 0;
 		}
+		storeSetPreferences();
 	}
-
-	storeSetPreferences();
 }
 
 void drawWIFIToggleScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
 	const char *wifiCaption = "WIFI";
 	int circleRadius = 17;
 	int spacing = 3;
@@ -1631,32 +2312,29 @@ void drawWIFIToggleScreen(Action *a)
 	int boxX = SCREEN_WIDTH / 2 - boxWidth / 2 + circleRadius;
 	int boxY = circleRadius;
 
-	bool isActive = availableActions[WIFI_ACTION].state == MS_RUNNING ? true : false;
+	bool isActive = screenState.actions[WIFI_ACTION] == MS_RUNNING ? true : false;
 	if (isActive)
 	{
-		mainCanvas.fillCircle(boxX, boxY, circleRadius, SSD1306_WHITE);
+		(*mainCanvas).fillCircle(boxX, boxY, circleRadius, SSD1306_WHITE);
 	}
 	else
 	{
-		mainCanvas.drawCircle(boxX, boxY, circleRadius, SSD1306_WHITE);
+		(*mainCanvas).drawCircle(boxX, boxY, circleRadius, SSD1306_WHITE);
 	}
-	int16_t x, y;
 	uint16_t w, h;
 	sprintf(stringPool10b1, "%s", isActive ? "on" : "off");
-	mainCanvas.getTextBounds(stringPool10b1, 0, 0, &x, &y, &w, &h);
-	mainCanvas.setCursor(boxX - w / 2 + w % 2, boxY - h / 2 + h % 2 + FONT_BASELINE_CORRECTION_NORMAL / 2);
-	mainCanvas.setTextColor(isActive ? SSD1306_BLACK : SSD1306_WHITE);
-	mainCanvas.setTextSize(MS_FONT_TEXT_SIZE_NORMAL);
-	mainCanvas.print(stringPool10b1);
-	mainCanvas.getTextBounds(wifiCaption, 0, 0, &x, &y, &w, &h);
-	mainCanvas.setTextColor(SSD1306_WHITE);
-	printPositionedText(&mainCanvas, wifiCaption, boxX - w / 2, boxY + circleRadius + spacing + FONT_BASELINE_CORRECTION_NORMAL);
+	_textBounds(mainCanvas, stringPool10b1, MS_FONT_TEXT_SIZE_NORMAL, &w, &h);
+	(*mainCanvas).setCursor(boxX - w / 2 + w % 2, boxY - h / 2 + h % 2 + FONT_BASELINE_CORRECTION_NORMAL / 2);
+	(*mainCanvas).setTextColor(isActive ? SSD1306_BLACK : SSD1306_WHITE);
+	(*mainCanvas).setTextSize(MS_FONT_TEXT_SIZE_NORMAL);
+	(*mainCanvas).print(stringPool10b1);
+	_textBounds(mainCanvas, wifiCaption, MS_FONT_TEXT_SIZE_NORMAL, &w, &h);
+	(*mainCanvas).setTextColor(SSD1306_WHITE);
+	printPositionedText(mainCanvas, wifiCaption, boxX - w / 2, boxY + circleRadius + spacing + FONT_BASELINE_CORRECTION_NORMAL);
 
 	boxX += circleRadius * 2 + spacing;
 
-	printAlignedText(&mainCanvas, "B1 - Back, B3 - toggle", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedText(mainCanvas, "B1 - Back, B3 - toggle", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleWIFIToggleScreen(int buttonValue)
@@ -1669,12 +2347,12 @@ void handleWIFIToggleScreen(int buttonValue)
 	{
 		if (availableActions[WIFI_ACTION].state == MS_RUNNING)
 		{
-			requestStop(&executionList, &availableActions[WIFI_ACTION]);
+			ms_sched_stop(&availableActions[WIFI_ACTION]);
 			wifi.isActive = false;
 		}
 		else if (availableActions[WIFI_ACTION].state == MS_NON_ACTIVE)
 		{
-			scheduleAction(&executionList, &availableActions[WIFI_ACTION]);
+			ms_sched_schedule(&availableActions[WIFI_ACTION]);
 			wifi.isActive = true;
 		}
 	}
@@ -1684,8 +2362,7 @@ void handleWIFIToggleScreen(int buttonValue)
 
 void drawBLEToggleScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
 	const char *wifiCaption = "Bluetooth";
 	int circleRadius = 17;
 	int spacing = 3;
@@ -1693,33 +2370,30 @@ void drawBLEToggleScreen(Action *a)
 	int boxX = SCREEN_WIDTH / 2 - boxWidth / 2 + circleRadius;
 	int boxY = circleRadius;
 
-	bool isActive = availableActions[BLE_ACTION].state == MS_RUNNING ? true : false;
+	bool isActive = screenState.actions[BLE_ACTION] == MS_RUNNING ? true : false;
 	if (isActive)
 	{
-		mainCanvas.fillCircle(boxX, boxY, circleRadius, SSD1306_WHITE);
+		(*mainCanvas).fillCircle(boxX, boxY, circleRadius, SSD1306_WHITE);
 	}
 	else
 	{
-		mainCanvas.drawCircle(boxX, boxY, circleRadius, SSD1306_WHITE);
+		(*mainCanvas).drawCircle(boxX, boxY, circleRadius, SSD1306_WHITE);
 	}
-	int16_t x, y;
 	uint16_t w, h;
-	sprintf(stringPool10b2, "%d", ble.connectedPeers);
+	sprintf(stringPool10b2, "%d", screenState.peers);
 	sprintf(stringPool10b1, "%s", isActive ? stringPool10b2 : "off");
-	mainCanvas.getTextBounds(stringPool10b1, 0, 0, &x, &y, &w, &h);
-	mainCanvas.setCursor(boxX - w / 2 + w % 2, boxY - h / 2 + h % 2 + FONT_BASELINE_CORRECTION_NORMAL / 2);
-	mainCanvas.setTextColor(isActive ? SSD1306_BLACK : SSD1306_WHITE);
-	mainCanvas.setTextSize(MS_FONT_TEXT_SIZE_NORMAL);
-	mainCanvas.print(stringPool10b1);
-	mainCanvas.getTextBounds(wifiCaption, 0, 0, &x, &y, &w, &h);
-	mainCanvas.setTextColor(SSD1306_WHITE);
-	printPositionedText(&mainCanvas, wifiCaption, boxX - w / 2, boxY + circleRadius + spacing + FONT_BASELINE_CORRECTION_NORMAL);
+	_textBounds(mainCanvas, stringPool10b1, MS_FONT_TEXT_SIZE_NORMAL, &w, &h);
+	(*mainCanvas).setCursor(boxX - w / 2 + w % 2, boxY - h / 2 + h % 2 + FONT_BASELINE_CORRECTION_NORMAL / 2);
+	(*mainCanvas).setTextColor(isActive ? SSD1306_BLACK : SSD1306_WHITE);
+	(*mainCanvas).setTextSize(MS_FONT_TEXT_SIZE_NORMAL);
+	(*mainCanvas).print(stringPool10b1);
+	_textBounds(mainCanvas, wifiCaption, MS_FONT_TEXT_SIZE_NORMAL, &w, &h);
+	(*mainCanvas).setTextColor(SSD1306_WHITE);
+	printPositionedText(mainCanvas, wifiCaption, boxX - w / 2, boxY + circleRadius + spacing + FONT_BASELINE_CORRECTION_NORMAL);
 
 	boxX += circleRadius * 2 + spacing;
 
-	printAlignedText(&mainCanvas, "B1 - Back, B3 - toggle", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedText(mainCanvas, "B1 - Back, B3 - toggle", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleBLEToggleScreen(int buttonValue)
@@ -1732,12 +2406,12 @@ void handleBLEToggleScreen(int buttonValue)
 	{
 		if (availableActions[BLE_ACTION].state == MS_RUNNING)
 		{
-			requestStop(&executionList, &availableActions[BLE_ACTION]);
+			ms_sched_stop(&availableActions[BLE_ACTION]);
 			ble.isActive = false;
 		}
 		else if (availableActions[BLE_ACTION].state == MS_NON_ACTIVE)
 		{
-			scheduleAction(&executionList, &availableActions[BLE_ACTION]);
+			ms_sched_schedule(&availableActions[BLE_ACTION]);
 			ble.isActive = true;
 		}
 	}
@@ -1747,8 +2421,7 @@ void handleBLEToggleScreen(int buttonValue)
 
 void drawConnectivityInfoScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
 	if (wifi.state != MS_WIFI_STOPPED)
 	{
 		String ip = WiFi.localIP().toString();
@@ -1760,15 +2433,13 @@ void drawConnectivityInfoScreen(Action *a)
 		sprintf(stringPool30b2, "SSID: %s", stringPool20b4);
 		sprintf(stringPool30b3, "Host: %s", WiFi.getHostname());
 		char *text[] = {stringPool30b1, stringPool30b2, stringPool30b3};
-		printAlignedTextStack(&mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+		printAlignedTextStack(mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
 	}
 	else
 	{
-		printAlignedText(&mainCanvas, "WIFI: OFF", MS_FONT_TEXT_SIZE_LARGE, MS_H_CENTER | MS_V_CENTER);
+		printAlignedText(mainCanvas, "WIFI: OFF", MS_FONT_TEXT_SIZE_LARGE, MS_H_CENTER | MS_V_CENTER);
 	}
-	printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleConnectivityInfoScreen(int buttonValue)
@@ -1782,16 +2453,13 @@ void handleConnectivityInfoScreen(int buttonValue)
 void drawConnectivitySettingsScreen(Action *a)
 {
 
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
 	char *text[] = {
 		"B2 - WiFi On/Off",
 		"B3 - BLE On/Off",
 		"B4 - Network info"};
-	printAlignedTextStack(&mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
-	printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedTextStack(mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+	printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleConnectivitySettingsScreen(int buttonValue)
@@ -1816,13 +2484,10 @@ void handleConnectivitySettingsScreen(int buttonValue)
 
 void drawMenuScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
 	char *text[] = {"B2 - Settings", "B3 - Processes", "B4 - Connectivity"};
-	printAlignedTextStack(&mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
-	printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedTextStack(mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+	printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleMenuScreen(int buttonValue)
@@ -1850,10 +2515,53 @@ char **stopped = (char **)calloc(sizeof(char *), ACTIONS_COUNT);
 char **pending = (char **)calloc(sizeof(char *), ACTIONS_COUNT);
 char **scheduled = (char **)calloc(sizeof(char *), ACTIONS_COUNT);
 
+// shows the actions with the longest ticks
+void drawProcessesTimings(Adafruit_GFX *canvas)
+{
+	const int rows = 3;
+	int slowest[rows] = {-1, -1, -1};
+
+	for (int i = 0; i < ACTIONS_COUNT; i++)
+	{
+		uint32_t max = screenState.stats[i].phases[MS_SCHED_PHASE_TICK].max;
+		for (int r = 0; r < rows; r++)
+		{
+			if (slowest[r] == -1 || max > screenState.stats[slowest[r]].phases[MS_SCHED_PHASE_TICK].max)
+			{
+				for (int m = rows - 1; m > r; m--)
+				{
+					slowest[m] = slowest[m - 1];
+				}
+				slowest[r] = i;
+				break;
+			}
+		}
+	}
+
+	char *rowsText[] = {stringPool30b2, stringPool30b3, stringPool30b4};
+	for (int r = 0; r < rows; r++)
+	{
+		Action *cur = &availableActions[slowest[r]];
+		const MSSchedStats *st = &screenState.stats[slowest[r]];
+		const MSSchedTiming *tick = &(*st).phases[MS_SCHED_PHASE_TICK];
+		snprintf(rowsText[r], sizeof(stringPool30b2), "%s %.1f/%.1f %lu", (*cur).name, _averageCallTime(tick) / 1000.0, (*tick).max / 1000.0, (unsigned long)(*st).overruns);
+	}
+
+	sprintf(stringPool30b1, "Tick avg/max ms, ovr");
+	char *message[] = {stringPool30b1, stringPool30b2, stringPool30b3, stringPool30b4};
+	printAlignedTextStack(canvas, message, 4, MS_FONT_TEXT_SIZE_NORMAL, MS_H_LEFT, MS_H_LEFT | MS_V_TOP);
+}
+
 void drawProcessesScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
+
+	if (screenState.pt)
+	{
+		drawProcessesTimings(mainCanvas);
+		printAlignedText(mainCanvas, "B1 - Back, B2 - states", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
+		return;
+	}
 
 	int stoppedCount = 0;
 	int pendingCount = 0;
@@ -1868,7 +2576,7 @@ void drawProcessesScreen(Action *a)
 	for (int i = 0; i < ACTIONS_COUNT; i++)
 	{
 		Action *current = &availableActions[i];
-		switch ((*current).state)
+		switch (screenState.actions[i])
 		{
 		case MS_PENDING:
 		case MS_CHILD_PENDING:
@@ -1894,16 +2602,14 @@ void drawProcessesScreen(Action *a)
 
 	char *message[] = {stringPool50b1, stringPool50b2, stringPool50b3, stringPool50b4};
 
-	printAlignedTextStack(&mainCanvas, message, 4, MS_FONT_TEXT_SIZE_NORMAL, MS_H_LEFT, MS_H_LEFT | MS_V_TOP);
+	printAlignedTextStack(mainCanvas, message, 4, MS_FONT_TEXT_SIZE_NORMAL, MS_H_LEFT, MS_H_LEFT | MS_V_TOP);
 
 	memset(stringPool50b1, 0, pendingCount);
 	memset(stringPool50b2, 0, stoppedCount);
 	memset(stringPool50b3, 0, scheduledCount);
 	memset(stringPool50b4, 0, runningCount);
 
-	printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedText(mainCanvas, "B1 - Back, B2 - timings", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleProcessesScreen(int buttonValue)
@@ -1911,18 +2617,20 @@ void handleProcessesScreen(int buttonValue)
 	if (buttonValue > BUTTON_1_LOW && buttonValue < BUTTON_1_HIGH)
 	{
 		state.scr = MS_MENU_SCREEN;
+		state.pt = false;
+	}
+	else if (buttonValue > BUTTON_2_LOW && buttonValue < BUTTON_2_HIGH)
+	{
+		state.pt = !state.pt;
 	}
 }
 
 void drawSettingsScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
 	char *text[] = {"B2 - Pump", "B3 - Sensors", "B4 - Thresholds"};
-	printAlignedTextStack(&mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
-	printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedTextStack(mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+	printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleSettingsScreen(int buttonValue)
@@ -1947,18 +2655,15 @@ void handleSettingsScreen(int buttonValue)
 
 void drawSensorIntervalsSettingsScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
 
-	sprintf(stringPool20b1, "Pump off: %lu s", settings.sid / 1000);
-	sprintf(stringPool20b2, "Pump on: %lu s", settings.siw / 1000);
-	sprintf(stringPool30b3, "ON duration: %lu s", availableActions[READ_SENSORS_ACTION].td / 1000);
+	sprintf(stringPool20b1, "Pump off: %lu s", screenState.settings.sid / 1000);
+	sprintf(stringPool20b2, "Pump on: %lu s", screenState.settings.siw / 1000);
+	sprintf(stringPool30b3, "ON duration: %lu s", screenState.sd / 1000);
 	char *message[] = {stringPool20b1, stringPool20b2, stringPool30b3};
-	printAlignedTextStack(&mainCanvas, message, 3, MS_FONT_TEXT_SIZE_NORMAL, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+	printAlignedTextStack(mainCanvas, message, 3, MS_FONT_TEXT_SIZE_NORMAL, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
 
-	printAlignedText(&mainCanvas, "B1 - Back, B2-B4 - Edit", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedText(mainCanvas, "B1 - Back, B2-B4 - Edit", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleSensorIntervalsSettingsScreen(int buttonValue)
@@ -1988,6 +2693,7 @@ void handleSensorIntervalsSettingsScreen(int buttonValue)
 		unsigned long *td = &availableActions[READ_SENSORS_ACTION].td;
 		int nv = _max(((*td) + step) % (upperLimit + step), step);
 		(*td) = nv;
+		ms_sched_touch(&availableActions[READ_SENSORS_ACTION]);
 	}
 
 	storeSetPreferences();
@@ -1995,33 +2701,29 @@ void handleSensorIntervalsSettingsScreen(int buttonValue)
 
 void drawPumpIrrigateMenuScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
-	Action *irrigateA = &availableActions[IRRIGATE_ACTION];
-	bool actionRunning = (*irrigateA).state == MS_RUNNING;
-	if ((*irrigateA).canStart(irrigateA))
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
+	bool actionRunning = screenState.actions[IRRIGATE_ACTION] == MS_RUNNING;
+	if (screenState.canIrrigate)
 	{
 		if (!actionRunning)
 		{
-			char *text[] = {"B2 - Near", "B3 - Mid", "B4 - Far"};
-			printAlignedTextStack(&mainCanvas, text, 3, MS_FONT_TEXT_SIZE_NORMAL, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
-			printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
+			char *text[MS_PICKER_BUTTONS];
+			int lines = _pickerText(text);
+			printAlignedTextStack(mainCanvas, text, lines, MS_FONT_TEXT_SIZE_NORMAL, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+			printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 		}
-		else if (sensorEditState.sensorCode != -1)
+		else if (screenState.zone != -1)
 		{
-			Sensor *s = &state.s[sensorEditState.sensorCode];
-			sprintf(stringPool10b1, "On: %s", (*s).name);
+			sprintf(stringPool10b1, "On: %s", zones[screenState.zone].name);
 			char *text[] = {stringPool10b1, "B2 - Off"};
-			printAlignedTextStack(&mainCanvas, text, 2, MS_FONT_TEXT_SIZE_LARGE, MS_H_CENTER | MS_V_CENTER);
+			printAlignedTextStack(mainCanvas, text, 2, MS_FONT_TEXT_SIZE_LARGE, MS_H_CENTER | MS_V_CENTER);
 		}
 	}
 	else
 	{
-		printAlignedText(&mainCanvas, "Cannot Start", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_CENTER);
-		printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
+		printAlignedText(mainCanvas, "Cannot Start", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_CENTER);
+		printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 	}
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
 }
 
 void handlePumpIrrigateMenuScreen(int buttonValue)
@@ -2031,7 +2733,7 @@ void handlePumpIrrigateMenuScreen(int buttonValue)
 	{
 		if (buttonValue > BUTTON_2_LOW && buttonValue < BUTTON_2_HIGH)
 		{
-			requestStop(&executionList, &availableActions[IRRIGATE_ACTION]);
+			ms_sched_stop(&availableActions[IRRIGATE_ACTION]);
 			sensorEditState.sensorCode = -1;
 		}
 	}
@@ -2039,37 +2741,28 @@ void handlePumpIrrigateMenuScreen(int buttonValue)
 	{
 		if (buttonValue > BUTTON_1_LOW && buttonValue < BUTTON_1_HIGH)
 		{
-			requestStop(&executionList, &availableActions[IRRIGATE_ACTION]);
+			ms_sched_stop(&availableActions[IRRIGATE_ACTION]);
 			sensorEditState.sensorCode = -1;
+			sensorEditState.page = 0;
 			state.scr = MS_PUMP_SETTINGS_MENU_SCREEN;
+			return;
 		}
-		else if (buttonValue > BUTTON_2_LOW && buttonValue < BUTTON_2_HIGH)
-		{
-			sensorEditState.sensorCode = MS_SENSOR_NEAR;
-			scheduleAction(&executionList, &availableActions[IRRIGATE_ACTION]);
-		}
-		else if (buttonValue > BUTTON_3_LOW && buttonValue < BUTTON_3_HIGH)
-		{
-			sensorEditState.sensorCode = MS_SENSOR_MID;
-			scheduleAction(&executionList, &availableActions[IRRIGATE_ACTION]);
-		}
-		else if (buttonValue > BUTTON_4_LOW && buttonValue < BUTTON_4_HIGH)
+
+		int zone = _pickerZone(buttonValue);
+		if (zone != -1)
 		{
-			sensorEditState.sensorCode = MS_SENSOR_FAR;
-			scheduleAction(&executionList, &availableActions[IRRIGATE_ACTION]);
+			sensorEditState.sensorCode = zone;
+			ms_sched_schedule(&availableActions[IRRIGATE_ACTION]);
 		}
 	}
 }
 
 void drawPumpSettingsScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
 	char *text[] = {"B2 - Intervals", "B3 - Clean", "B4 - Irrigate"};
-	printAlignedTextStack(&mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
-	printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedTextStack(mainCanvas, text, 3, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+	printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handlePumpSettingsScreen(int buttonValue)
@@ -2094,16 +2787,13 @@ void handlePumpSettingsScreen(int buttonValue)
 
 void drawPumpIntervalsSettingsScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
-	sprintf(stringPool20b1, "max(T): %lu min", settings.pd / 60000);
-	sprintf(stringPool30b2, "Re-act in: %lu min", settings.pi / 60000);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
+	sprintf(stringPool20b1, "max(T): %lu min", screenState.settings.pd / 60000);
+	sprintf(stringPool30b2, "Re-act in: %lu min", screenState.settings.pi / 60000);
 	char *message[] = {stringPool20b1, stringPool30b2};
-	printAlignedTextStack(&mainCanvas, message, 2, MS_FONT_TEXT_SIZE_NORMAL, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+	printAlignedTextStack(mainCanvas, message, 2, MS_FONT_TEXT_SIZE_NORMAL, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
 
-	printAlignedText(&mainCanvas, "B1 - Back, B2-B3 - edit", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedText(mainCanvas, "B1 - Back, B2-B3 - edit", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handlePumpIntervalsSettingsScreen(int buttonValue)
@@ -2132,29 +2822,25 @@ void handlePumpIntervalsSettingsScreen(int buttonValue)
 
 void drawPumpCleaningInfoScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
-	Action *ca = &availableActions[CLEAN_PUMP_ACTION];
-	if ((*ca).canStart(ca))
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
+	if (screenState.canClean)
 	{
-		if ((*ca).state == MS_NON_ACTIVE)
+		if (screenState.actions[CLEAN_PUMP_ACTION] == MS_NON_ACTIVE)
 		{
 			char *message1[] = {"Press B2", "to", "start"};
-			printAlignedTextStack(&mainCanvas, message1, 3, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER, MS_H_CENTER | MS_V_CENTER);
+			printAlignedTextStack(mainCanvas, message1, 3, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER, MS_H_CENTER | MS_V_CENTER);
 		}
 		else
 		{
 			char *message1[] = {"Press B2", "to", "stop"};
-			printAlignedTextStack(&mainCanvas, message1, 3, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER, MS_H_CENTER | MS_V_CENTER);
+			printAlignedTextStack(mainCanvas, message1, 3, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER, MS_H_CENTER | MS_V_CENTER);
 		}
 	}
 	else
 	{
-		printAlignedText(&mainCanvas, "Cannot Start", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_CENTER);
+		printAlignedText(mainCanvas, "Cannot Start", MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_CENTER);
 	}
-	printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handlePumpCleaningInfoScreen(int buttonValue)
@@ -2163,31 +2849,28 @@ void handlePumpCleaningInfoScreen(int buttonValue)
 	if (buttonValue > BUTTON_1_LOW && buttonValue < BUTTON_1_HIGH)
 	{
 		state.scr = MS_PUMP_SETTINGS_MENU_SCREEN;
-		requestStop(&executionList, ca);
+		ms_sched_stop(ca);
 	}
 	else if (buttonValue > BUTTON_2_LOW && buttonValue < BUTTON_2_HIGH)
 	{
 
 		if ((*ca).state == MS_NON_ACTIVE)
 		{
-			scheduleAction(&executionList, ca);
+			ms_sched_schedule(ca);
 		}
 		else
 		{
-			requestStop(&executionList, ca);
+			ms_sched_stop(ca);
 		}
 	}
 }
 
 void drawIntervalsSettingsScreen(Action *a)
 {
-	GFXcanvas16 mainCanvas = GFXcanvas16(SCREEN_WIDTH, SCREEN_HEIGHT);
-	initCanvas(&mainCanvas);
+	Adafruit_GFX *mainCanvas = beginFrame(&display);
 	char *text[] = {"B2 - Pump intervals", "B3 - Sensor intervals"};
-	printAlignedTextStack(&mainCanvas, text, 2, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
-	printAlignedText(&mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
-	display.drawRGBBitmap(0, 0, mainCanvas.getBuffer(), mainCanvas.width(), mainCanvas.height());
-	display.display();
+	printAlignedTextStack(mainCanvas, text, 2, 1, MS_H_LEFT, MS_H_CENTER | MS_V_TOP);
+	printAlignedText(mainCanvas, MS_BACK_BUTTON_PROMPT, MS_FONT_TEXT_SIZE_NORMAL, MS_H_CENTER | MS_V_BOTTOM);
 }
 
 void handleIntervalsSettingsScreen(int buttonValue)
@@ -2206,6 +2889,9 @@ void handleIntervalsSettingsScreen(int buttonValue)
 	}
 }
 
+// Runs on the loop task, so the screen handlers may change the
+// settings, the zones state and the Action fields; only drawing
+// is left to the ticks on the UI worker
 void startBuildScreen(Action *a)
 {
 	int newValue = readButton();
@@ -2215,20 +2901,124 @@ void startBuildScreen(Action *a)
 	}
 
 	button.value = newValue;
-	display.clearDisplay();
+
+	if (button.hasChanged && state.scr < SCREENS_COUNT)
+	{
+		availableScreens[state.scr].handleButtons(button.value);
+		button.hasChanged = false;
+		// the screen, the settings or what is being edited changed
+		touchState();
+	}
+}
+
+// Bumps the state version if the action states or
+// the peers count changed since the last frame
+void _watchState()
+{
+	bool changed = ble.connectedPeers != watchedState.peers;
+	watchedState.peers = ble.connectedPeers;
+	for (int i = 0; i < ACTIONS_COUNT; i++)
+	{
+		changed = changed || availableActions[i].state != watchedState.actions[i];
+		watchedState.actions[i] = availableActions[i].state;
+	}
+
+	if (changed)
+	{
+		touchState();
+	}
+}
+
+// Copies what the screens show; runs on the loop task before each tick
+void snapshotScreen(Action *a)
+{
+	_watchState();
+
+	MSScreenState *s = &screenState;
+	MSZonesState *z = state.z;
+	(*s).version = stateVersion;
+	(*s).scr = state.scr;
+	(*s).p = state.p;
+	(*s).sa = state.sa;
+	(*s).pt = state.pt;
+	memcpy((*s).zp, (*z).p, sizeof((*s).zp));
+	memcpy((*s).wet, (*z).wet, sizeof((*s).wet));
+	memcpy((*s).dry, (*z).dry, sizeof((*s).dry));
+	memcpy((*s).apv, (*z).apv, sizeof((*s).apv));
+	memcpy((*s).dapv, (*z).dapv, sizeof((*s).dapv));
+	memcpy((*s).active, (*z).active, sizeof((*s).active));
+	memcpy((*s).v, (*z).v, sizeof((*s).v));
+	(*s).settings = settings;
+	(*s).sd = availableActions[READ_SENSORS_ACTION].td;
+	(*s).zone = sensorEditState.sensorCode;
+	(*s).page = sensorEditState.page;
+	(*s).calibration = sensorEditState.state;
+	(*s).spread = ms_calibration_spread(&sensorEditState.calibration);
+	for (int i = 0; i < ACTIONS_COUNT; i++)
+	{
+		(*s).actions[i] = availableActions[i].state;
+	}
+	(*s).canCalibrate = ms_sched_can_start(&availableActions[CALIBRATE_SENSOR_ACTION]);
+	(*s).canIrrigate = ms_sched_can_start(&availableActions[IRRIGATE_ACTION]);
+	(*s).canClean = ms_sched_can_start(&availableActions[CLEAN_PUMP_ACTION]);
+	(*s).bleActive = ble.isActive;
+	(*s).peers = watchedState.peers;
+
+	if (state.scr == MS_PROCESSES_SCREEN && state.pt)
+	{
+		for (int i = 0; i < ACTIONS_COUNT; i++)
+		{
+			(*s).stats[i] = *ms_sched_stats(&availableActions[i]);
+		}
+	}
+}
+
+// Whether the display no longer shows the current
+// state of the screen or the screen itself
+bool _frameOutdated(int screenIndex, unsigned long now)
+{
+	if (!drawnFrame.valid || drawnFrame.screen != screenIndex || drawnFrame.version != screenState.version)
+	{
+		return true;
+	}
+
+	// time dependent screens are redrawn on multiples of their refresh
+	unsigned long refresh = availableScreens[screenIndex].refresh;
+	return refresh > 0 && now / refresh != drawnFrame.at / refresh;
 }
 
 void tickBuildScreen(Action *a)
 {
-	int screenIndex = state.scr;
+	int screenIndex = screenState.scr;
 	if (screenIndex < SCREENS_COUNT)
 	{
 		MSScreen *current = (MSScreen *)&availableScreens[screenIndex];
-		(*current).drawUI(a);
-		if (button.hasChanged)
+		unsigned long now = millis();
+		if (_frameOutdated(screenIndex, now))
+		{
+			uint32_t version = screenState.version;
+			int64_t startedAt = ms_sched_now();
+			(*current).drawUI(a);
+			int64_t renderedAt = ms_sched_now();
+			submitDisplay(&display);
+			int64_t submittedAt = ms_sched_now();
+
+			drawnFrame.valid = true;
+			drawnFrame.version = version;
+			drawnFrame.screen = screenIndex;
+			drawnFrame.at = now;
+
+			uint32_t render = (uint32_t)(renderedAt - startedAt);
+			uint32_t submit = (uint32_t)(submittedAt - renderedAt);
+			frameStats.frames++;
+			frameStats.renderTotal += render;
+			frameStats.renderMax = _max(frameStats.renderMax, render);
+			frameStats.submitTotal += submit;
+			frameStats.submitMax = _max(frameStats.submitMax, submit);
+		}
+		else
 		{
-			(*current).handleButtons(button.value);
-			button.hasChanged = false;
+			frameStats.skipped++;
 		}
 	}
 }
@@ -2243,32 +3033,15 @@ void stopBuildScreen(Action *a)
 
 // Pump
 
-bool irrigateCanStart(Action *a)
-{
-	return availableActions[PUMP_ACTION].state != MS_CHILD_RUNNING && availableActions[CLEAN_PUMP_ACTION].state != MS_RUNNING;
-}
-
 void startIrrigate(Action *a)
 {
 	if (sensorEditState.sensorCode != -1)
 	{
 		digitalWrite(PUMP_PIN, PUMP_PIN_HIGH);
 		state.p = true;
-		switch (sensorEditState.sensorCode)
-		{
-		case MS_SENSOR_NEAR:
-			digitalWrite(PIN_VALVE_NEAR, VALVE_PIN_HIGH);
-			state.vn = true;
-			break;
-		case MS_SENSOR_MID:
-			digitalWrite(PIN_VALVE_MID, VALVE_PIN_HIGH);
-			state.vm = true;
-			break;
-		case MS_SENSOR_FAR:
-			digitalWrite(PIN_VALVE_FAR, VALVE_PIN_HIGH);
-			state.vf = true;
-			break;
-		}
+		digitalWrite(zones[sensorEditState.sensorCode].valvePin, VALVE_PIN_HIGH);
+		(*state.z).v[sensorEditState.sensorCode] = true;
+		touchState();
 	}
 }
 
@@ -2280,23 +3053,19 @@ void stopIrrigate(Action *a)
 {
 	digitalWrite(PUMP_PIN, PUMP_PIN_LOW);
 	state.p = false;
-	digitalWrite(PIN_VALVE_NEAR, VALVE_PIN_LOW);
-	state.vn = false;
-	digitalWrite(PIN_VALVE_MID, VALVE_PIN_LOW);
-	state.vm = false;
-	digitalWrite(PIN_VALVE_FAR, VALVE_PIN_LOW);
-	state.vf = false;
-}
-
-bool cleanPumpCanStart(Action *a)
-{
-	return availableActions[PUMP_ACTION].state != MS_CHILD_RUNNING && availableActions[IRRIGATE_ACTION].state != MS_RUNNING && availableActions[READ_SENSORS_ACTION].state != MS_RUNNING;
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		digitalWrite(zones[i].valvePin, VALVE_PIN_LOW);
+		(*state.z).v[i] = false;
+	}
+	touchState();
 }
 
 void startCleanPump(Action *a)
 {
 	digitalWrite(PUMP_PIN, PUMP_PIN_HIGH);
 	state.p = true;
+	touchState();
 }
 
 void tickCleanPump(Action *a)
@@ -2307,18 +3076,21 @@ void stopCleanPump(Action *a)
 {
 	digitalWrite(PUMP_PIN, PUMP_PIN_LOW);
 	state.p = false;
+	touchState();
 }
 
 void startPump(Action *a)
 {
 	digitalWrite(PUMP_PIN, PUMP_PIN_HIGH);
 	state.p = true;
+	touchState();
 }
 
 void stopPump(Action *a)
 {
 	digitalWrite(PUMP_PIN, PUMP_PIN_LOW);
 	state.p = false;
+	touchState();
 }
 
 void tickPump(Action *a)
@@ -2333,6 +3105,8 @@ void populateScreens()
 {
 	availableScreens[MS_HOME_SCREEN].drawUI = &drawHomeScreen;
 	availableScreens[MS_HOME_SCREEN].handleButtons = &handleHomeScreen;
+	// the zones are paged every MS_HOME_PAGE_MS
+	availableScreens[MS_HOME_SCREEN].refresh = ZONES_COUNT > MS_HOME_PAGE_SIZE ? MS_HOME_PAGE_MS : 0;
 
 	availableScreens[MS_SETTINGS_SCREEN].drawUI = &drawSettingsScreen;
 	availableScreens[MS_SETTINGS_SCREEN].handleButtons = &handleSettingsScreen;
@@ -2378,6 +3152,8 @@ void populateScreens()
 
 	availableScreens[MS_PROCESSES_SCREEN].drawUI = &drawProcessesScreen;
 	availableScreens[MS_PROCESSES_SCREEN].handleButtons = &handleProcessesScreen;
+	// the call timings change all the time
+	availableScreens[MS_PROCESSES_SCREEN].refresh = 1000;
 
 	availableScreens[MS_MENU_SCREEN].drawUI = &drawMenuScreen;
 	availableScreens[MS_MENU_SCREEN].handleButtons = &handleMenuScreen;
@@ -2399,14 +3175,14 @@ void populateActions()
 {
 
 	// calibrate sensor action
-	availableActions[CALIBRATE_SENSOR_ACTION].canStart = &calibrateSensorCanStart;
+	availableActions[CALIBRATE_SENSOR_ACTION].canStart = nullptr;
 	availableActions[CALIBRATE_SENSOR_ACTION].tick = &tickCalibrateSensor;
 	availableActions[CALIBRATE_SENSOR_ACTION].frozen = false; // when stopped the action will be removed from the list
 	availableActions[CALIBRATE_SENSOR_ACTION].start = &startCalibrateSensor;
 	availableActions[CALIBRATE_SENSOR_ACTION].stop = &stopCalibrateSensor;
 	availableActions[CALIBRATE_SENSOR_ACTION].ti = 1;
 	availableActions[CALIBRATE_SENSOR_ACTION].td = 0; // duration of 0 means we never stop
-	availableActions[CALIBRATE_SENSOR_ACTION].to = 0;
+	availableActions[CALIBRATE_SENSOR_ACTION].to = MS_SENSOR_CALIBRATION_TICK_MS;
 	availableActions[CALIBRATE_SENSOR_ACTION].state = MS_NON_ACTIVE;
 	availableActions[CALIBRATE_SENSOR_ACTION].child = nullptr;
 	availableActions[CALIBRATE_SENSOR_ACTION].lst = 0;
@@ -2420,7 +3196,7 @@ void populateActions()
 	availableActions[WIFI_ACTION].stop = &stopWifi;
 	availableActions[WIFI_ACTION].ti = 1;
 	availableActions[WIFI_ACTION].td = 0; // duration of 0 means we never stop
-	availableActions[WIFI_ACTION].to = 0;
+	availableActions[WIFI_ACTION].to = 10; // poll the web server every 10ms
 	availableActions[WIFI_ACTION].state = MS_NON_ACTIVE;
 	availableActions[WIFI_ACTION].child = nullptr;
 	availableActions[WIFI_ACTION].lst = 0;
@@ -2434,7 +3210,7 @@ void populateActions()
 	availableActions[BLE_ACTION].stop = &ms_ble_stop;
 	availableActions[BLE_ACTION].ti = 1;
 	availableActions[BLE_ACTION].td = 0; // duration of 0 means we never stop
-	availableActions[BLE_ACTION].to = 0;
+	availableActions[BLE_ACTION].to = 0; // ticked when the host queue gets an event (ms_ble_start)
 	availableActions[BLE_ACTION].state = MS_NON_ACTIVE;
 	availableActions[BLE_ACTION].child = nullptr;
 	availableActions[BLE_ACTION].lst = 0;
@@ -2457,70 +3233,37 @@ void populateActions()
 	availableActions[INTERPRET_SENSOR_DATA_ACTION].name = "interpret";
 
 	// read sensors action
-	availableActions[READ_SENSORS_ACTION].canStart = &readSensorsCanStart;
+	availableActions[READ_SENSORS_ACTION].canStart = nullptr;
 	availableActions[READ_SENSORS_ACTION].tick = &tickSensors;
 	availableActions[READ_SENSORS_ACTION].frozen = true;
 	availableActions[READ_SENSORS_ACTION].start = &startSensors;
 	availableActions[READ_SENSORS_ACTION].stop = &stopSensors;
 	availableActions[READ_SENSORS_ACTION].ti = settings.siw;
 	availableActions[READ_SENSORS_ACTION].td = settings.sd;
-	availableActions[READ_SENSORS_ACTION].to = 200;
+	availableActions[READ_SENSORS_ACTION].to = MS_ADC_COLLECT_PERIOD_MS;
 	availableActions[READ_SENSORS_ACTION].state = MS_NON_ACTIVE;
 	availableActions[READ_SENSORS_ACTION].child = nullptr;
 	availableActions[READ_SENSORS_ACTION].lst = 0;
 	availableActions[READ_SENSORS_ACTION].st = 0;
 	availableActions[READ_SENSORS_ACTION].name = "sensors";
 
-	// open far valve action
-	availableActions[OUTLET_FAR_ACTION].canStart = &canStartOutlet;
-	availableActions[OUTLET_FAR_ACTION].tick = &tickFarOutlet;
-	availableActions[OUTLET_FAR_ACTION].frozen = false;
-	availableActions[OUTLET_FAR_ACTION].start = &startFarOutlet;
-	availableActions[OUTLET_FAR_ACTION].stop = &stopFarOutlet;
-	availableActions[OUTLET_FAR_ACTION].ti = settings.pi;
-	availableActions[OUTLET_FAR_ACTION].td = settings.pd;
-	availableActions[OUTLET_FAR_ACTION].to = 0;
-	availableActions[OUTLET_FAR_ACTION].state = MS_NON_ACTIVE;
-	availableActions[OUTLET_FAR_ACTION].child = &availableActions[PUMP_ACTION];
-	availableActions[OUTLET_FAR_ACTION].lst = 0;
-	availableActions[OUTLET_FAR_ACTION].st = 0;
-	availableActions[OUTLET_FAR_ACTION].name = "valve-far";
-
-	state.s[MS_SENSOR_FAR].ai = OUTLET_FAR_ACTION;
-
-	// open mid valve action
-	availableActions[OUTLET_MID_ACTION].canStart = &canStartOutlet;
-	availableActions[OUTLET_MID_ACTION].tick = &tickMidOutlet;
-	availableActions[OUTLET_MID_ACTION].frozen = false;
-	availableActions[OUTLET_MID_ACTION].start = &startMidOutlet;
-	availableActions[OUTLET_MID_ACTION].stop = &stopMidOutlet;
-	availableActions[OUTLET_MID_ACTION].ti = settings.pi;
-	availableActions[OUTLET_MID_ACTION].td = settings.pd;
-	availableActions[OUTLET_MID_ACTION].to = 0;
-	availableActions[OUTLET_MID_ACTION].state = MS_NON_ACTIVE;
-	availableActions[OUTLET_MID_ACTION].child = &availableActions[PUMP_ACTION];
-	availableActions[OUTLET_MID_ACTION].lst = 0;
-	availableActions[OUTLET_MID_ACTION].st = 0;
-	availableActions[OUTLET_MID_ACTION].name = "valve-mid";
-
-	state.s[MS_SENSOR_MID].ai = OUTLET_MID_ACTION;
-
-	// open near valve action
-	availableActions[OUTLET_NEAR_ACTION].canStart = &canStartOutlet;
-	availableActions[OUTLET_NEAR_ACTION].tick = &tickNearOutlet;
-	availableActions[OUTLET_NEAR_ACTION].frozen = false;
-	availableActions[OUTLET_NEAR_ACTION].start = &startNearOutlet;
-	availableActions[OUTLET_NEAR_ACTION].stop = &stopNearOutlet;
-	availableActions[OUTLET_NEAR_ACTION].ti = settings.pi;
-	availableActions[OUTLET_NEAR_ACTION].td = settings.pd;
-	availableActions[OUTLET_NEAR_ACTION].to = 0;
-	availableActions[OUTLET_NEAR_ACTION].state = MS_NON_ACTIVE;
-	availableActions[OUTLET_NEAR_ACTION].child = &availableActions[PUMP_ACTION];
-	availableActions[OUTLET_NEAR_ACTION].lst = 0;
-	availableActions[OUTLET_NEAR_ACTION].st = 0;
-	availableActions[OUTLET_NEAR_ACTION].name = "valve-near";
-
-	state.s[MS_SENSOR_NEAR].ai = OUTLET_NEAR_ACTION;
+	// open valve actions, one per zone
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		availableActions[OUTLET_ACTION(i)].canStart = nullptr;
+		availableActions[OUTLET_ACTION(i)].tick = &tickOutlet;
+		availableActions[OUTLET_ACTION(i)].frozen = false;
+		availableActions[OUTLET_ACTION(i)].start = &startOutlet;
+		availableActions[OUTLET_ACTION(i)].stop = &stopOutlet;
+		availableActions[OUTLET_ACTION(i)].ti = settings.pi;
+		availableActions[OUTLET_ACTION(i)].td = settings.pd;
+		availableActions[OUTLET_ACTION(i)].to = 0;
+		availableActions[OUTLET_ACTION(i)].state = MS_NON_ACTIVE;
+		availableActions[OUTLET_ACTION(i)].child = &availableActions[PUMP_ACTION];
+		availableActions[OUTLET_ACTION(i)].lst = 0;
+		availableActions[OUTLET_ACTION(i)].st = 0;
+		availableActions[OUTLET_ACTION(i)].name = zones[i].outlet;
+	}
 
 	// start pump action
 	availableActions[PUMP_ACTION].tick = &tickPump;
@@ -2537,7 +3280,7 @@ void populateActions()
 	availableActions[PUMP_ACTION].name = "pump";
 
 	// irrigate action
-	availableActions[IRRIGATE_ACTION].canStart = &irrigateCanStart;
+	availableActions[IRRIGATE_ACTION].canStart = nullptr;
 	availableActions[IRRIGATE_ACTION].tick = &tickIrrigate;
 	availableActions[IRRIGATE_ACTION].frozen = false;
 	availableActions[IRRIGATE_ACTION].start = &startIrrigate;
@@ -2551,8 +3294,23 @@ void populateActions()
 	availableActions[IRRIGATE_ACTION].st = 0;
 	availableActions[IRRIGATE_ACTION].name = "irrigate";
 
+	// settings action; triggered by the web server with an edit
+	availableActions[APPLY_SETTINGS_ACTION].canStart = nullptr;
+	availableActions[APPLY_SETTINGS_ACTION].tick = &tickApplySettings;
+	availableActions[APPLY_SETTINGS_ACTION].frozen = false;
+	availableActions[APPLY_SETTINGS_ACTION].start = &startApplySettings;
+	availableActions[APPLY_SETTINGS_ACTION].stop = &stopApplySettings;
+	availableActions[APPLY_SETTINGS_ACTION].ti = 1;
+	availableActions[APPLY_SETTINGS_ACTION].td = 1;
+	availableActions[APPLY_SETTINGS_ACTION].to = 0;
+	availableActions[APPLY_SETTINGS_ACTION].state = MS_NON_ACTIVE;
+	availableActions[APPLY_SETTINGS_ACTION].child = nullptr;
+	availableActions[APPLY_SETTINGS_ACTION].lst = 0;
+	availableActions[APPLY_SETTINGS_ACTION].st = 0;
+	availableActions[APPLY_SETTINGS_ACTION].name = "settings";
+
 	// clean pump action
-	availableActions[CLEAN_PUMP_ACTION].canStart = &cleanPumpCanStart;
+	availableActions[CLEAN_PUMP_ACTION].canStart = nullptr;
 	availableActions[CLEAN_PUMP_ACTION].tick = &tickCleanPump;
 	availableActions[CLEAN_PUMP_ACTION].frozen = false;
 	availableActions[CLEAN_PUMP_ACTION].start = &startCleanPump;
@@ -2573,7 +3331,7 @@ void populateActions()
 	availableActions[DRAW_UI_ACTION].stop = &stopBuildScreen;
 	availableActions[DRAW_UI_ACTION].ti = 1000;
 	availableActions[DRAW_UI_ACTION].td = 100;
-	availableActions[DRAW_UI_ACTION].to = 0;
+	availableActions[DRAW_UI_ACTION].to = 20; // at most 50 frames per second
 	availableActions[DRAW_UI_ACTION].state = MS_NON_ACTIVE;
 	availableActions[DRAW_UI_ACTION].child = nullptr;
 	availableActions[DRAW_UI_ACTION].lst = 0;
@@ -2581,27 +3339,88 @@ void populateActions()
 	availableActions[DRAW_UI_ACTION].name = "ui";
 }
 
+// Max duration of a single start/tick/stop call in us;
+// longer calls are counted as overruns
+void setActionBudgets()
+{
+	ms_sched_set_budget(&availableActions[READ_SENSORS_ACTION], 20000);
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		ms_sched_set_budget(&availableActions[OUTLET_ACTION(i)], 1000);
+	}
+	ms_sched_set_budget(&availableActions[PUMP_ACTION], 1000);
+	ms_sched_set_budget(&availableActions[DRAW_UI_ACTION], 50000);
+	ms_sched_set_budget(&availableActions[WIFI_ACTION], 20000);
+	ms_sched_set_budget(&availableActions[INTERPRET_SENSOR_DATA_ACTION], 1000);
+	ms_sched_set_budget(&availableActions[CALIBRATE_SENSOR_ACTION], 5000);
+	ms_sched_set_budget(&availableActions[BLE_ACTION], 5000);
+	ms_sched_set_budget(&availableActions[CLEAN_PUMP_ACTION], 1000);
+	ms_sched_set_budget(&availableActions[IRRIGATE_ACTION], 1000);
+}
+
+// Actuator transitions are critical; UI and WiFi ticks
+// yield to them, everything else keeps the default priority
+void setActionPriorities()
+{
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		ms_sched_set_priority(&availableActions[OUTLET_ACTION(i)], MS_SCHED_PRIORITY_CRITICAL);
+	}
+	ms_sched_set_priority(&availableActions[PUMP_ACTION], MS_SCHED_PRIORITY_CRITICAL);
+	ms_sched_set_priority(&availableActions[IRRIGATE_ACTION], MS_SCHED_PRIORITY_CRITICAL);
+	ms_sched_set_priority(&availableActions[CLEAN_PUMP_ACTION], MS_SCHED_PRIORITY_CRITICAL);
+	ms_sched_set_priority(&availableActions[DRAW_UI_ACTION], MS_SCHED_PRIORITY_BEST_EFFORT);
+	ms_sched_set_priority(&availableActions[WIFI_ACTION], MS_SCHED_PRIORITY_BEST_EFFORT);
+}
+
+// Actions which keep an action from starting while they run; each
+// line is one of the former canStart predicates. The relation is one
+// way (irrigation does not wait for a sensors read, outlets do not
+// wait for an irrigation), as it was with the predicates
+void setActionBlockers()
+{
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		ms_sched_set_blocked_by(&availableActions[OUTLET_ACTION(i)], MS_SCHED_BIT(CLEAN_PUMP_ACTION) | MS_SCHED_BIT(CALIBRATE_SENSOR_ACTION));
+	}
+	ms_sched_set_blocked_by(&availableActions[CALIBRATE_SENSOR_ACTION], MS_SCHED_BIT(READ_SENSORS_ACTION) | MS_SCHED_BIT(IRRIGATE_ACTION) | OUTLET_ACTIONS);
+	ms_sched_set_blocked_by(&availableActions[READ_SENSORS_ACTION], MS_SCHED_BIT(CALIBRATE_SENSOR_ACTION) | MS_SCHED_BIT(IRRIGATE_ACTION) | MS_SCHED_BIT(CLEAN_PUMP_ACTION));
+	ms_sched_set_blocked_by(&availableActions[IRRIGATE_ACTION], MS_SCHED_BIT(CLEAN_PUMP_ACTION) | OUTLET_ACTIONS);
+	ms_sched_set_blocked_by(&availableActions[CLEAN_PUMP_ACTION], MS_SCHED_BIT(IRRIGATE_ACTION) | MS_SCHED_BIT(READ_SENSORS_ACTION) | OUTLET_ACTIONS);
+}
+
+// Rendering and HTTP run next to the Arduino core (1), away from
+// sensors, interpretation, actuators and NimBLE on core 0. They are
+// the only actions demotion may move to a worker; the ticks of the
+// others touch state owned by the loop task and are slowed instead
+void setActionWorkers()
+{
+	ms_sched_set_snapshot(&availableActions[DRAW_UI_ACTION], &snapshotScreen);
+	ms_sched_set_offloadable(&availableActions[DRAW_UI_ACTION], true);
+	ms_sched_set_offloadable(&availableActions[WIFI_ACTION], true);
+#ifdef MS_MULTICORE_EXECUTOR
+	ms_sched_set_worker(&availableActions[DRAW_UI_ACTION], 1);
+	ms_sched_set_worker(&availableActions[WIFI_ACTION], 1);
+#endif
+}
+
+// 0 (no button) when the pin could not be read
 int readButton()
 {
-	return fixedAnalogRead(BUTTONS_PIN);
+	int value;
+	return fixedAnalogRead(BUTTONS_PIN, &value) ? value : 0;
 }
 
 void storeSetPreferences()
 {
 	preferences.begin(MS_PREFERENCES_ID, false);
 	preferences.putBool(MS_IRRIGATE_UNTIL_EXPIRY_KEY, settings.iue);
-	preferences.putBool(MS_FAR_ACTIVE_SETTING_KEY, state.s[MS_SENSOR_FAR].active);
-	preferences.putBool(MS_MID_ACTIVE_SETTING_KEY, state.s[MS_SENSOR_MID].active);
-	preferences.putBool(MS_NEAR_ACTIVE_SETTING_KEY, state.s[MS_SENSOR_NEAR].active);
-
-	preferences.putInt(MS_APV_NEAR_SETTING_KEY, state.s[MS_SENSOR_NEAR].apv);
-	preferences.putInt(MS_DAPV_NEAR_SETTING_KEY, state.s[MS_SENSOR_NEAR].dapv);
-
-	preferences.putInt(MS_APV_MID_SETTING_KEY, state.s[MS_SENSOR_MID].apv);
-	preferences.putInt(MS_DAPV_MID_SETTING_KEY, state.s[MS_SENSOR_MID].dapv);
-
-	preferences.putInt(MS_APV_FAR_SETTING_KEY, state.s[MS_SENSOR_FAR].apv);
-	preferences.putInt(MS_DAPV_FAR_SETTING_KEY, state.s[MS_SENSOR_FAR].dapv);
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		preferences.putBool(zones[i].activeKey, (*state.z).active[i]);
+		preferences.putInt(zones[i].apvKey, (*state.z).apv[i]);
+		preferences.putInt(zones[i].dapvKey, (*state.z).dapv[i]);
+	}
 
 	preferences.putBool(MS_WIFI_TOGGLE_SETTING_KEY, wifi.isActive);
 	preferences.putBool(MS_BLE_TOGGLE_SETTING_KEY, ble.isActive);
@@ -2620,26 +3439,14 @@ void readStoredPreferences()
 {
 	preferences.begin(MS_PREFERENCES_ID, false);
 
-	state.s[MS_SENSOR_NEAR].dry = preferences.getInt(MS_NEAR_DRY_SETTING_KEY);
-	state.s[MS_SENSOR_MID].dry = preferences.getInt(MS_MID_DRY_SETTING_KEY);
-	state.s[MS_SENSOR_FAR].dry = preferences.getInt(MS_FAR_DRY_SETTING_KEY);
-
-	state.s[MS_SENSOR_NEAR].wet = preferences.getInt(MS_NEAR_WET_SETTING_KEY);
-	state.s[MS_SENSOR_MID].wet = preferences.getInt(MS_MID_WET_SETTING_KEY);
-	state.s[MS_SENSOR_FAR].wet = preferences.getInt(MS_FAR_WET_SETTING_KEY);
-
-	state.s[MS_SENSOR_NEAR].active = preferences.getBool(MS_NEAR_ACTIVE_SETTING_KEY, true);
-	state.s[MS_SENSOR_MID].active = preferences.getBool(MS_MID_ACTIVE_SETTING_KEY, true);
-	state.s[MS_SENSOR_FAR].active = preferences.getBool(MS_FAR_ACTIVE_SETTING_KEY, true);
-
-	state.s[MS_SENSOR_NEAR].apv = preferences.getInt(MS_APV_NEAR_SETTING_KEY, 50);
-	state.s[MS_SENSOR_NEAR].dapv = preferences.getInt(MS_DAPV_NEAR_SETTING_KEY, 85);
-
-	state.s[MS_SENSOR_MID].apv = preferences.getInt(MS_APV_MID_SETTING_KEY, 50);
-	state.s[MS_SENSOR_MID].dapv = preferences.getInt(MS_DAPV_MID_SETTING_KEY, 85);
-
-	state.s[MS_SENSOR_FAR].apv = preferences.getInt(MS_APV_FAR_SETTING_KEY, 50);
-	state.s[MS_SENSOR_FAR].dapv = preferences.getInt(MS_DAPV_FAR_SETTING_KEY, 85);
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		(*state.z).dry[i] = preferences.getInt(zones[i].dryKey);
+		(*state.z).wet[i] = preferences.getInt(zones[i].wetKey);
+		(*state.z).active[i] = preferences.getBool(zones[i].activeKey, true);
+		(*state.z).apv[i] = preferences.getInt(zones[i].apvKey, 50);
+		(*state.z).dapv[i] = preferences.getInt(zones[i].dapvKey, 85);
+	}
 
 	settings.pd = preferences.getULong(MS_PUMP_MAX_DURATION_SETTING_KEY, settings.pd);
 	settings.pi = preferences.getULong(MS_PUMP_REACT_INT_DURATION_SETTING_KEY, settings.pi);
@@ -2652,14 +3459,11 @@ void readStoredPreferences()
 	wifi.isActive = preferences.getBool(MS_WIFI_TOGGLE_SETTING_KEY, wifi.isActive);
 	ble.isActive = preferences.getBool(MS_BLE_TOGGLE_SETTING_KEY, ble.isActive);
 
-	availableActions[OUTLET_NEAR_ACTION].ti = settings.pi;
-	availableActions[OUTLET_NEAR_ACTION].td = settings.pd;
-
-	availableActions[OUTLET_MID_ACTION].ti = settings.pi;
-	availableActions[OUTLET_MID_ACTION].td = settings.pd;
-
-	availableActions[OUTLET_FAR_ACTION].ti = settings.pi;
-	availableActions[OUTLET_FAR_ACTION].td = settings.pd;
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		availableActions[OUTLET_ACTION(i)].ti = settings.pi;
+		availableActions[OUTLET_ACTION(i)].td = settings.pd;
+	}
 
 	availableActions[READ_SENSORS_ACTION].ti = settings.siw;
 	availableActions[READ_SENSORS_ACTION].td = settings.sd;
@@ -2669,16 +3473,16 @@ void readStoredPreferences()
 
 void scheduleDefaultActions()
 {
-	scheduleAction(&executionList, &availableActions[READ_SENSORS_ACTION]);
-	scheduleAction(&executionList, &availableActions[DRAW_UI_ACTION]);
+	ms_sched_schedule(&availableActions[READ_SENSORS_ACTION]);
+	ms_sched_schedule(&availableActions[DRAW_UI_ACTION]);
 	if (wifi.isActive)
 	{
-		scheduleAction(&executionList, &availableActions[WIFI_ACTION]);
+		ms_sched_schedule(&availableActions[WIFI_ACTION]);
 	}
 
 	if (ble.isActive)
 	{
-		scheduleAction(&executionList, &availableActions[BLE_ACTION]);
+		ms_sched_schedule(&availableActions[BLE_ACTION]);
 	}
 }
 
@@ -2695,6 +3499,25 @@ void setupInitialState()
 		// populate the available actions
 		populateActions();
 
+		// edits of the web server waiting for the settings action
+		settingsEdits.queue = xQueueCreate(MS_SETTINGS_EDITS_SIZE, sizeof(MSSettingsEdit));
+		settingsEdits.applied = xSemaphoreCreateBinary();
+
+		// order the actions by deadline
+		ms_sched_init(&executionList);
+
+		// set the time budgets of the actions
+		setActionBudgets();
+
+		// valves and pump go before UI and WiFi
+		setActionPriorities();
+
+		// actions which keep others from starting
+		setActionBlockers();
+
+		// move the UI and web server ticks off the control core
+		setActionWorkers();
+
 		// set initial screen to draw
 		state.scr = MS_HOME_SCREEN;
 
@@ -2713,7 +3536,7 @@ void allocateMemPools()
 {
 	availableScreens = (MSScreen *)calloc(SCREENS_COUNT, sizeof(MSScreen));
 	availableActions = (Action *)calloc(ACTIONS_COUNT, sizeof(Action));
-	state.s = (Sensor *)calloc(SENSORS_COUNT, sizeof(Sensor));
+	state.z = (MSZonesState *)calloc(1, sizeof(MSZonesState));
 }
 
 void initDisplay(Adafruit_SSD1306 *display)
@@ -2725,6 +3548,102 @@ void initDisplay(Adafruit_SSD1306 *display)
 			; // Don't proceed, loop forever
 	}
 	(*display).clearDisplay();
+
+	// from here on the flush task is the only user of the bus
+	if (xTaskCreatePinnedToCore(&_runDisplayFlush, "ms_display", MS_DISPLAY_FLUSH_STACK_SIZE, nullptr, MS_DISPLAY_FLUSH_PRIORITY, &displayService.task, MS_DISPLAY_FLUSH_CORE) != pdPASS)
+	{
+		displayService.task = nullptr;
+		ESP_LOGE("mothership", "Display flush task failed, flushing on the caller");
+	}
+}
+
+// Reads a calibration point (dry or wet) of all zones in one pass.
+// The zones are sampled in turn, a batch each every
+// MS_SENSOR_CALIBRATION_TICK_MS, and the pass ends as soon as all of
+// them are stable. The progress shown is the share of the readings
+// the noisiest zone needs so far.
+void _bootCalibrate(int *target, const char *caption)
+{
+	MSCalibration c[ZONES_COUNT];
+	MSSettle st[ZONES_COUNT];
+	int values[ZONES_COUNT][MS_CALIBRATION_BATCH];
+	int64_t startedAt = ms_sched_now();
+	int64_t drawnAt = 0;
+
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		ms_calibration_reset(&c[i]);
+		ms_settle_reset(&st[i], startedAt);
+	}
+
+	while (true)
+	{
+		// interleaved, so drift during the batch hits all zones alike;
+		// failed reads are left out
+		int counts[ZONES_COUNT] = {0};
+		for (int k = 0; k < MS_CALIBRATION_BATCH; k++)
+		{
+			for (int i = 0; i < ZONES_COUNT; i++)
+			{
+				if (fixedAnalogRead(zones[i].sensorPin, &values[i][counts[i]]))
+				{
+					counts[i]++;
+				}
+			}
+		}
+
+		int64_t now = ms_sched_now();
+		bool stable = true;
+		uint32_t readings = UINT32_MAX;
+		int percent = 100;
+		for (int i = 0; i < ZONES_COUNT; i++)
+		{
+			int total = 0;
+			for (int k = 0; k < counts[i]; k++)
+			{
+				total += values[i][k];
+			}
+
+			// the readings taken while settling are dropped
+			if (counts[i] > 0 && !st[i].settled && ms_settle_push(&st[i], total / counts[i], now))
+			{
+				ms_calibration_reset(&c[i]);
+			}
+
+			for (int k = 0; k < counts[i]; k++)
+			{
+				ms_calibration_push(&c[i], values[i][k]);
+			}
+
+			stable = stable && st[i].settled && ms_calibration_stable(&c[i], MS_BOOT_CALIBRATION_MIN_READINGS, MS_BOOT_CALIBRATION_ERROR);
+			readings = _min(readings, c[i].count);
+
+			// readings needed for the standard error to reach the bound
+			int spread = ms_calibration_spread(&c[i]) / MS_BOOT_CALIBRATION_ERROR;
+			uint32_t needed = _max((uint32_t)MS_BOOT_CALIBRATION_MIN_READINGS, (uint32_t)(spread * spread));
+			percent = st[i].settled ? _min(percent, (int)((uint64_t)c[i].count * 100 / needed)) : 0;
+		}
+
+		if (stable || now - startedAt >= (int64_t)MS_BOOT_CALIBRATION_MAX_MS * 1000)
+		{
+			break;
+		}
+
+		if (now - drawnAt >= (int64_t)MS_BOOT_CALIBRATION_DRAW_MS * 1000)
+		{
+			showCalibrationProgressScreen(&display, caption, _min(percent, 99), readings);
+			drawnAt = now;
+		}
+		delay(MS_SENSOR_CALIBRATION_TICK_MS);
+	}
+
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		target[i] = ms_calibration_mean(&c[i]);
+		ESP_LOGI("mothership", "Boot calibrated %s: %d, spread %d, %lu readings, settled in %lums",
+				 zones[i].name, target[i], ms_calibration_spread(&c[i]), (unsigned long)c[i].count, (unsigned long)st[i].time);
+	}
+	ESP_LOGI("mothership", "Boot calibration took %lldms", (long long)((ms_sched_now() - startedAt) / 1000));
 }
 
 void ms_init()
@@ -2759,9 +3678,6 @@ void ms_init()
 		}
 	}
 
-	sprintf(state.s[MS_SENSOR_NEAR].name, "near");
-	sprintf(state.s[MS_SENSOR_MID].name, "mid");
-	sprintf(state.s[MS_SENSOR_FAR].name, "far");
 	// we start with stored values normally
 	if (!init)
 	{
@@ -2770,20 +3686,12 @@ void ms_init()
 		readStoredPreferences();
 
 #else
-		int nd = 0, md = 0, fd = 0, nw = 0, mw = 0, fw = 0;
-		EEPROM.get(0, nd);
-		EEPROM.get(sizeof(int), md);
-		EEPROM.get(sizeof(int) * 2, fd);
-		EEPROM.get(sizeof(int) * 3, nw);
-		EEPROM.get(sizeof(int) * 4, mw);
-		EEPROM.get(sizeof(int) * 5, fw);
-		state.s[MS_SENSOR_NEAR].dry = nd;
-		state.s[MS_SENSOR_MID].dry = md;
-		state.s[MS_SENSOR_FAR].dry = fd;
-
-		state.s[MS_SENSOR_NEAR].wet = nw;
-		state.s[MS_SENSOR_MID].wet = mw;
-		state.s[MS_SENSOR_FAR].wet = fw;
+		// all dry values first, then all wet values
+		for (int i = 0; i < ZONES_COUNT; i++)
+		{
+			EEPROM.get(sizeof(int) * i, (*state.z).dry[i]);
+			EEPROM.get(sizeof(int) * (ZONES_COUNT + i), (*state.z).wet[i]);
+		}
 #endif
 		showTextCaptionScreen(&display, MS_STARTING_PROMPT_TEXT);
 		// drawStartingValuesScreen(&display);
@@ -2809,24 +3717,18 @@ void ms_init()
 			br = readButton();
 		}
 		display.clearDisplay();
-		showTextCaptionScreen(&display, MS_READING_PROMPT_TEXT);
 
-		// waiting for completely wet values
-		extractMedianPinValueForProperty(1000, &state.s[MS_SENSOR_NEAR].dry, PIN_NEAR);
-		extractMedianPinValueForProperty(1000, &state.s[MS_SENSOR_MID].dry, PIN_MID);
-		extractMedianPinValueForProperty(1000, &state.s[MS_SENSOR_FAR].dry, PIN_FAR);
+		_bootCalibrate((*state.z).dry, "Reading dry...");
+		for (int i = 0; i < ZONES_COUNT; i++)
+		{
 #ifdef ARDUINO_ARCH_ESP32
-		preferences.putInt(MS_NEAR_DRY_SETTING_KEY, state.s[MS_SENSOR_NEAR].dry);
-		preferences.putInt(MS_MID_DRY_SETTING_KEY, state.s[MS_SENSOR_MID].dry);
-		preferences.putInt(MS_FAR_DRY_SETTING_KEY, state.s[MS_SENSOR_FAR].dry);
+			preferences.putInt(zones[i].dryKey, (*state.z).dry[i]);
 #else
-		EEPROM.put(0, state.s[MS_SENSOR_NEAR].dry);
-		EEPROM.put(sizeof(int), state.s[MS_SENSOR_MID].dry);
-		EEPROM.put(sizeof(int) * 2, state.s[MS_SENSOR_FAR].dry);
+			EEPROM.put(sizeof(int) * i, (*state.z).dry[i]);
 #endif
+		}
 
-		drawDryValuesScreen(&display);
-		delay(5000);
+		showZoneValuesScreens(&display, "Dry values:", (*state.z).dry, 5000);
 		display.clearDisplay();
 		showActionPromptScreen(&display, "B2 for", "wet state");
 		br = readButton();
@@ -2835,25 +3737,19 @@ void ms_init()
 			br = readButton();
 		}
 		display.clearDisplay();
-		showTextCaptionScreen(&display, MS_READING_PROMPT_TEXT);
 
-		// waiting for completely wet values
-		extractMedianPinValueForProperty(1000, &state.s[MS_SENSOR_NEAR].wet, PIN_NEAR);
-		extractMedianPinValueForProperty(1000, &state.s[MS_SENSOR_MID].wet, PIN_MID);
-		extractMedianPinValueForProperty(1000, &state.s[MS_SENSOR_FAR].wet, PIN_FAR);
+		_bootCalibrate((*state.z).wet, "Reading wet...");
+		for (int i = 0; i < ZONES_COUNT; i++)
+		{
 #ifdef ARDUINO_ARCH_ESP32
-		preferences.putInt(MS_NEAR_WET_SETTING_KEY, state.s[MS_SENSOR_NEAR].wet);
-		preferences.putInt(MS_MID_WET_SETTING_KEY, state.s[MS_SENSOR_MID].wet);
-		preferences.putInt(MS_FAR_WET_SETTING_KEY, state.s[MS_SENSOR_FAR].wet);
+			preferences.putInt(zones[i].wetKey, (*state.z).wet[i]);
 #else
-		EEPROM.put(sizeof(int) * 3, state.s[MS_SENSOR_NEAR].wet);
-		EEPROM.put(sizeof(int) * 4, state.s[MS_SENSOR_MID].wet);
-		EEPROM.put(sizeof(int) * 5, state.s[MS_SENSOR_FAR].wet);
+			EEPROM.put(sizeof(int) * (ZONES_COUNT + i), (*state.z).wet[i]);
 #endif
+		}
 
 		// wet values have been read
-		drawWetValuesScreen(&display);
-		delay(5000);
+		showZoneValuesScreens(&display, "Wet values:", (*state.z).wet, 5000);
 		display.clearDisplay();
 		showActionPromptScreen(&display, "B2", "start...");
 		// click to continue
@@ -2869,6 +3765,8 @@ void ms_init()
 		preferences.end();
 #endif
 	}
+
+	ms_interpret_scales((*state.z).dry, (*state.z).wet, (*state.z).scale, ZONES_COUNT);
 }
 
 // Fix for WIFI + analogRead from ADC2 issue
@@ -2894,11 +3792,26 @@ void restoreADC2ConfigRegisters()
 // Read the following threads for more information:
 // https://github.com/espressif/arduino-esp32/issues/102
 // https://github.com/espressif/arduino-esp32/issues/440
-int fixedAnalogRead(int pin)
+// False (value unchanged) when the pin could not be read
+bool fixedAnalogRead(int pin, int *value)
 {
+	// the ADC1 pins are read through ms_adc; the workaround
+	// is only needed for analogRead on ADC2
+	if (ms_adc_has_pin(pin))
+	{
+		// analogRead fails on the pins ms_adc owns
+		if (!ms_adc_read(pin, value))
+		{
+			ESP_LOGW("mothership", "No reading of pin %d", pin);
+			return false;
+		}
+		return true;
+	}
+
 	restoreADC2ConfigRegisters();
 	SET_PERI_REG_MASK(SENS_SAR_READ_CTRL2_REG, SENS_SAR2_DATA_INV);
-	return analogRead(pin);
+	(*value) = analogRead(pin);
+	return true;
 }
 
 //
@@ -2921,20 +3834,27 @@ void setup()
 	storeADC2ConfigRegisters();
 
 	ESP_LOGI("mothership", "Setting pin modes...");
-	pinMode(PIN_FAR, INPUT);
-	pinMode(PIN_MID, INPUT);
-	pinMode(PIN_NEAR, INPUT);
-
-	pinMode(PIN_VALVE_FAR, OUTPUT);
-	pinMode(PIN_VALVE_MID, OUTPUT);
-	pinMode(PIN_VALVE_NEAR, OUTPUT);
-
-	digitalWrite(PIN_VALVE_FAR, HIGH);
-	digitalWrite(PIN_VALVE_MID, HIGH);
-	digitalWrite(PIN_VALVE_NEAR, HIGH);
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		pinMode(zones[i].sensorPin, INPUT);
+		pinMode(zones[i].valvePin, OUTPUT);
+		digitalWrite(zones[i].valvePin, HIGH);
+	}
 
 	pinMode(BUTTONS_PIN, INPUT);
 
+	ESP_LOGI("mothership", "Setting up the ADC...");
+	int sampledPins[ZONES_COUNT + 1];
+	for (int i = 0; i < ZONES_COUNT; i++)
+	{
+		sampledPins[i] = zones[i].sensorPin;
+	}
+	sampledPins[ZONES_COUNT] = BUTTONS_PIN;
+	if (!ms_adc_init(sampledPins, ZONES_COUNT + 1))
+	{
+		ESP_LOGW("mothership", "ADC driver unavailable, falling back to analogRead");
+	}
+
 	pinMode(PUMP_PIN, OUTPUT); // pump relay
 	digitalWrite(PUMP_PIN, PUMP_PIN_LOW);
 
@@ -2960,7 +3880,10 @@ void setup()
 
 void loop()
 {
-	doQueueActions(&executionList, millis());
+	ms_sched_run(ms_sched_now());
+#ifdef MS_TICKLESS_LOOP
+	ms_sched_wait(ms_sched_now());
+#endif
 }
 
 extern "C" void app_main(void)
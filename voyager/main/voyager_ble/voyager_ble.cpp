@@ -15,6 +15,7 @@
 #include "characteristics/voyager_primary.h"
 #include "esp_random.h"
 #include "modules/actions/actions.h"
+#include "voyager_scheduler/voyager_scheduler.h"
 
 extern "C" void ble_store_config_init(void);
 
@@ -26,6 +27,40 @@ static uint8_t own_addr_type;
 
 static ble_uuid16_t *advertisedService = (ble_uuid16_t *)calloc(1, sizeof(ble_uuid16_t));
 static voyager_app_context *context;
+static void (*hostEventqPut)(struct ble_npl_eventq *evq, struct ble_npl_event *ev) = nullptr;
+
+// posts to the host queue and wakes the loop to run the event
+static void voyager_eventq_put(struct ble_npl_eventq *evq, struct ble_npl_event *ev)
+{
+    hostEventqPut(evq, ev);
+
+    if (xPortInIsrContext())
+    {
+        vy_sched_wake_from_isr();
+    }
+    else
+    {
+        vy_sched_wake();
+    }
+}
+
+// routes every event posted to the host queue (HCI events and data from
+// the controller, expired callouts) through voyager_eventq_put
+static bool voyager_hook_eventq()
+{
+    npl_funcs_t *nplFuncs = npl_freertos_funcs_get();
+    if (nplFuncs == nullptr || nplFuncs->p_ble_npl_eventq_put == nullptr)
+    {
+        return false;
+    }
+
+    if (nplFuncs->p_ble_npl_eventq_put != &voyager_eventq_put)
+    {
+        hostEventqPut = nplFuncs->p_ble_npl_eventq_put;
+        nplFuncs->p_ble_npl_eventq_put = &voyager_eventq_put;
+    }
+    return true;
+}
 
 static void
 voyager_print_addr(const void *addr)
@@ -405,6 +440,12 @@ void vy_ble_start(Action *a)
     {
         ESP_LOGE(voyager_tag, "Could not initialize BLE: %d", rc);
     }
+
+    if (!voyager_hook_eventq())
+    {
+        ESP_LOGW(voyager_tag, "Unable to hook the host queue; polling it");
+        a->to = VY_BLE_POLL_MS;
+    }
 }
 void vy_ble_tick(Action *a)
 {
@@ -413,8 +454,9 @@ void vy_ble_tick(Action *a)
     struct ble_npl_event *ev;
     npl_funcs_t *nplFuncs = npl_freertos_funcs_get();
 
-    ev = nplFuncs->p_ble_npl_eventq_get(eventQueue, portTICK_PERIOD_MS);
-    if (ev)
+    // run everything queued since the last tick without blocking;
+    // the next event posted wakes the loop for another pass
+    while ((ev = nplFuncs->p_ble_npl_eventq_get(eventQueue, 0)) != nullptr)
     {
         nplFuncs->p_ble_npl_event_run(ev);
     }
@@ -1,6 +1,11 @@
 #ifndef _VOYAGER_BLE_h
 #define _VOYAGER_BLE_h
 #include "modules/actions/actions.h"
+
+// tick interval of the BLE action if the host queue cannot be hooked;
+// otherwise it ticks (to = 0) on every pass an event woke the loop for
+#define VY_BLE_POLL_MS 10
+
 void vy_ble_start(Action *a);
 void vy_ble_tick(Action *a);
 void vy_ble_stop(Action *a);
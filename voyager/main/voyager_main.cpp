@@ -9,6 +9,7 @@
 #include "modules/actions/actions.h"
 #include "voyager_ble/voyager_ble.h"
 #include "voyager_ble_led/voyager_ble_led.h"
+#include "voyager_scheduler/voyager_scheduler.h"
 #include "voyager_main.h"
 #include "host/util/util.h"
 #include "nvs_flash.h"
@@ -34,7 +35,7 @@ Action availableActions[] = {
         .ti = 1,
         .td = 0,
         .lst = 0,
-        .to = 0,
+        .to = 0, // ticked on every pass an event on the host queue wakes the loop for
         .state = MS_NON_ACTIVE,
         .tick = &vy_ble_tick,
         .start = &vy_ble_start,
@@ -48,7 +49,7 @@ Action availableActions[] = {
         .ti = 1,
         .td = 0,
         .lst = 0,
-        .to = 0,
+        .to = 250, // the LED only reflects the connection state
         .state = MS_NON_ACTIVE,
         .tick = &vy_ble_led_tick,
         .start = &vy_ble_led_start,
@@ -81,12 +82,15 @@ extern "C" void app_main(void)
     setup_nvs_flash();
 
     initActionsList(ACTIONS_COUNT);
+    vy_sched_init(availableActions, sizeof(availableActions) / sizeof(Action));
     scheduleAction(&executionList, &availableActions[VY_BLE_ACTION_INDEX]);
     scheduleAction(&executionList, &availableActions[VY_LED_ACTION_INDEX]);
 
     while (true)
     {
         doQueueActions(&executionList, esp_log_timestamp());
+        // sleep until the next action deadline so the idle task can run
+        vy_sched_wait(esp_log_timestamp());
     }
 
     ESP_LOGI(voyager_tag, "Initialized Nimble...");
@@ -0,0 +1,100 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "voyager_scheduler.h"
+
+static Action *actions = nullptr;
+static int actionsCount = 0;
+static TaskHandle_t loopTask = nullptr;
+
+static bool is_after(unsigned long a, unsigned long b)
+{
+    return (long)(a - b) > 0;
+}
+
+static unsigned long next_deadline(unsigned long now)
+{
+    unsigned long next = now + VY_SCHED_MAX_IDLE_MS;
+
+    for (int i = 0; i < actionsCount; i++)
+    {
+        Action *a = &actions[i];
+        unsigned long d;
+
+        if (a->state == MS_NON_ACTIVE)
+        {
+            continue;
+        }
+        else if (a->state == MS_RUNNING || a->state == MS_CHILD_RUNNING)
+        {
+            if (a->to == 0)
+            {
+                // ticks on every pass the action wakes us for
+                if (a->td == 0)
+                {
+                    continue;
+                }
+                d = a->st + a->td;
+            }
+            else
+            {
+                // we don't know when the library last ticked the action,
+                // so we wake up at most one interval from now
+                d = now + a->to;
+                if (a->td > 0 && is_after(d, a->st + a->td))
+                {
+                    d = a->st + a->td;
+                }
+            }
+        }
+        else
+        {
+            d = a->lst > 0 ? a->lst + a->ti : now;
+        }
+
+        if (is_after(next, d))
+        {
+            next = d;
+        }
+    }
+
+    return next;
+}
+
+void vy_sched_init(Action *list, int count)
+{
+    actions = list;
+    actionsCount = count;
+    loopTask = xTaskGetCurrentTaskHandle();
+}
+
+void vy_sched_wait(unsigned long now)
+{
+    unsigned long next = next_deadline(now);
+    if (!is_after(next, now))
+    {
+        return;
+    }
+
+    // round up so we never wake before the deadline
+    TickType_t ticks = (TickType_t)((next - now + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);
+    ulTaskNotifyTake(pdTRUE, ticks);
+}
+
+void vy_sched_wake()
+{
+    if (loopTask != nullptr)
+    {
+        xTaskNotifyGive(loopTask);
+    }
+}
+
+void vy_sched_wake_from_isr()
+{
+    if (loopTask != nullptr)
+    {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(loopTask, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
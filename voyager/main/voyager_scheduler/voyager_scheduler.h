@@ -0,0 +1,23 @@
+#ifndef _VOYAGER_SCHEDULER_h
+#define _VOYAGER_SCHEDULER_h
+#include "modules/actions/actions.h"
+
+/*
+ * Lets the main loop sleep until the earliest action deadline instead of
+ * spinning on doQueueActions. The loop task is woken early by
+ * vy_sched_wake (other tasks) or vy_sched_wake_from_isr (interrupts).
+ * Actions ticking on every pass (to = 0) add no deadline: they have to
+ * wake the loop when they have work, as the BLE action does for every
+ * event posted to the host queue.
+ */
+
+// upper bound for a single sleep so state changes made inside the
+// Actions library are always picked up eventually
+#define VY_SCHED_MAX_IDLE_MS 1000
+
+void vy_sched_init(Action *actions, int count);
+void vy_sched_wait(unsigned long now);
+void vy_sched_wake();
+void vy_sched_wake_from_isr();
+
+#endif